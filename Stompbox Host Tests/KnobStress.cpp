@@ -0,0 +1,143 @@
+// Knob detent stress test: how many encoder detents does the loop lose to the rotary interrupt?
+//
+// Runs on the PC, not the device. A timer signal stands in for the rotary encoder interrupt (handleKnobChange:
+// one detent each, added by the firmware's own addKnobDetent), firing every few microseconds while a stand-in loop
+// takes the accumulated changes, two ways:
+//
+//   before:  read delta, act on it, then zero it (scanControls with consumeKnobChanges, before takeKnobChanges)
+//   after:   the firmware's own takeKnobChanges (StompboxKnobs.h), then act on it
+//
+// Every detent the interrupt adds should come out of the loop exactly once; the rest were lost (or, if negative,
+// counted twice). Blocking the signal stands in for noInterrupts() (see hostSetInterrupts, for host/Arduino.h).
+// The PC reads an int in one go, so the torn 16-bit read an AVR can also suffer isn't reproduced here: the 'before'
+// losses are a lower bound.
+//
+//   make knob-stress && ./knob-stress [seconds per pattern, default 2]
+//
+// Exits non-zero if the 'after' pattern loses or duplicates a detent.
+
+#include "../StompboxKnobs.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/time.h>
+
+volatile knob_state_s knob_state;
+volatile long detents_turned = 0;       // every detent the "interrupt" has added
+
+/// stand-in for handleKnobChange(ii): one detent clockwise
+void handleKnobInterrupt(int) {
+  addKnobDetent(knob_state, +1);
+  detents_turned++;
+}
+
+// for host/Arduino.h: the signal is the interrupt, so holding interrupts off is blocking it
+
+sigset_t knob_signal;
+
+void hostSetInterrupts(bool enabled) {
+  sigprocmask(enabled ? SIG_UNBLOCK : SIG_BLOCK, &knob_signal, nullptr);
+}
+
+bool hostInterruptsEnabled() {
+  sigset_t blocked;
+  sigprocmask(SIG_BLOCK, nullptr, &blocked);
+  return !sigismember(&blocked, SIGALRM);
+}
+
+unsigned long micros() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+/// stand-in for the loop's work on a change (meta knob checks, OSC send): long enough for the interrupt to land in
+void actOnKnobChange() {
+  for (volatile int ii = 0; ii < 200; ii++) {
+  }
+}
+
+/// the old pattern, kept as the baseline: read the change, act on it, then zero it (an interrupt in between is lost)
+long takeBefore() {
+
+  long taken = 0;
+  if (knob_state.changed) {
+    taken = knob_state.delta;
+    actOnKnobChange();
+  }
+  knob_state.delta = 0;
+  knob_state.changed = false;
+  return taken;
+
+}
+
+/// the current pattern: takeKnobChanges, then act on it
+long takeAfter() {
+
+  time_us edge_time;
+  long taken = takeKnobChanges(knob_state, &edge_time);
+
+  if (taken != 0) {
+    actOnKnobChange();
+  }
+  return taken;
+
+}
+
+/// run the loop with one pattern for this long; print the counts, and return how many detents went missing
+long stress(const char *name, long (*take)(), double seconds) {
+
+  knob_state.delta = 0;
+  knob_state.changed = false;
+  detents_turned = 0;
+
+  // the "encoder": as fast as the timer goes (the kernel rounds it up; tens of microseconds is typical)
+  itimerval timer = { { 0, 10 }, { 0, 10 } };
+  setitimer(ITIMER_REAL, &timer, nullptr);
+
+  long taken = 0;
+  long scans = 0;
+  timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do {
+    taken += take();
+    scans++;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while ((now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9 < seconds);
+
+  itimerval off = { { 0, 0 }, { 0, 0 } };
+  setitimer(ITIMER_REAL, &off, nullptr);
+  taken += takeAfter(); // whatever's left over since the last scan
+
+  long lost = detents_turned - taken;
+  printf("%-8s %10ld detents turned  %10ld taken  %10ld lost (%.2f%%)  over %ld scans\n",
+    name, (long)detents_turned, taken, lost, detents_turned ? lost * 100.0 / detents_turned : 0.0, scans);
+  return lost;
+
+}
+
+int main(int argc, char *argv[]) {
+
+  double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+
+  sigemptyset(&knob_signal);
+  sigaddset(&knob_signal, SIGALRM);
+
+  struct sigaction action = {};
+  action.sa_handler = handleKnobInterrupt;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGALRM, &action, nullptr);
+
+  stress("before", takeBefore, seconds);
+  long lost = stress("after", takeAfter, seconds);
+
+  if (lost != 0) {
+    printf("FAIL: takeKnobChanges lost %ld detents\n", lost);
+    return 1;
+  }
+  return 0;
+
+}
@@ -0,0 +1,173 @@
+// Pedal smoothing test: the One-Euro filter (StompboxOneEuro.h) against the SLIP example's EMA, over pedal traces.
+//
+// Each trace (traces/*.csv: time_us,adc,truth; see make_traces.py) goes through both filters the way scanControls
+// feeds them: the One-Euro one as a 16-bit position (adcToCurvePosition) with the reading's time, back to ADC counts;
+// the EMA as plain ADC counts, one reading at a time. For each, in ADC counts:
+//
+//   jitter:  peak-to-peak output where the pedal has been still for half a second
+//   changes: how often the output changes there (each one a packet, but for the pedal's change threshold)
+//   lag:     the furthest the output falls behind the pedal while it moves
+//   settle:  once the pedal stops, how long until the output is within the change threshold of it (ms)
+//
+//   make one-euro-test && ./one-euro-test
+//
+// Exits non-zero if the One-Euro filter misses its bounds (below), jitters as much as the EMA, or lags further behind.
+// The filter's tuning and the change threshold are the firmware's own (StompboxOneEuro.h).
+
+#include "../StompboxOneEuro.h"
+#include "../StompboxCurves.h"
+#include "../SLIP/Arduino Example/SLIP-OSC-Reaper/EMA.hpp"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// the bounds the One-Euro filter must keep to, in ADC counts and ms
+// (and no more lag than the EMA's)
+const int MAX_JITTER = 1;
+const double MAX_SETTLE_MS = 20;
+
+const double STILL_US = 500000;     // still this long before jitter counts
+
+typedef struct reading_s {
+  unsigned long time;
+  int adc;
+  double truth;
+} reading_s;
+
+typedef struct result_s {
+  int jitter;
+  int changes;
+  double lag;
+  double settle_ms;
+} result_s;
+
+std::vector<reading_s> readTrace(const char *path) {
+
+  std::vector<reading_s> trace;
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return trace;
+  }
+  fscanf(file, "%*[^\n]\n"); // header
+  reading_s reading;
+  while (fscanf(file, "%lu,%d,%lf\n", &reading.time, &reading.adc, &reading.truth) == 3) {
+    trace.push_back(reading);
+  }
+  fclose(file);
+  return trace;
+
+}
+
+/// measure a filter's output against the trace's truth
+result_s measure(const std::vector<reading_s> &trace, const std::vector<int> &output) {
+
+  result_s result = { 0, 0, 0.0, 0.0 };
+  unsigned long still_since = trace[0].time;
+  unsigned long stopped_at = 0;
+  bool settling = false;
+  int low = 1023, high = 0, previous = -1;
+
+  for (size_t ii = 0; ii < trace.size(); ii++) {
+    const reading_s &reading = trace[ii];
+    double error = std::fabs(output[ii] - reading.truth);
+
+    bool moving = (ii > 0) && (std::fabs(reading.truth - trace[ii - 1].truth) > 0.05);
+    if (moving) {
+      still_since = reading.time;
+      settling = true;
+      stopped_at = 0;
+      if (error > result.lag) {
+        result.lag = error;
+      }
+      previous = -1;
+      continue;
+    }
+
+    // stopped: settling?
+    if (settling) {
+      if (stopped_at == 0) {
+        stopped_at = reading.time;
+      }
+      if (error <= PEDAL_THRESHOLD) {
+        settling = false;
+        double settle_ms = (reading.time - stopped_at) / 1000.0;
+        if (settle_ms > result.settle_ms) {
+          result.settle_ms = settle_ms;
+        }
+      }
+    }
+
+    // still for long enough: jitter
+    if (reading.time - still_since >= STILL_US) {
+      if (output[ii] < low) {
+        low = output[ii];
+      }
+      if (output[ii] > high) {
+        high = output[ii];
+      }
+      if ((previous >= 0) && (output[ii] != previous)) {
+        result.changes++;
+      }
+      previous = output[ii];
+      if (high - low > result.jitter) {
+        result.jitter = high - low;
+      }
+    } else {
+      low = 1023;
+      high = 0;
+      previous = -1;
+    }
+  }
+  return result;
+
+}
+
+void print(const char *name, const result_s &result) {
+  printf("  %-9s jitter %2d  changes %3d  lag %5.1f  settle %5.1f ms\n",
+    name, result.jitter, result.changes, result.lag, result.settle_ms);
+}
+
+int main(int argc, char *argv[]) {
+
+  const char *traces[] = { "traces/rest.csv", "traces/slow_sweep.csv", "traces/wah_rock.csv" };
+  bool pass = true;
+
+  for (const char *path : traces) {
+
+    std::vector<reading_s> trace = readTrace(path);
+    if (trace.empty()) {
+      printf("%s: can't read it\n", path);
+      return 1;
+    }
+
+    PedalFilter one_euro;
+    EMA<2, int16_t> ema;
+    std::vector<int> one_euro_output, ema_output;
+    for (const reading_s &reading : trace) {
+      one_euro_output.push_back(one_euro.filter(adcToCurvePosition(reading.adc), reading.time) >> 6);
+      ema_output.push_back(ema.filter(reading.adc));
+    }
+
+    result_s one_euro_result = measure(trace, one_euro_output);
+    result_s ema_result = measure(trace, ema_output);
+    printf("%s (%zu readings)\n", path, trace.size());
+    print("one-euro", one_euro_result);
+    print("ema", ema_result);
+
+    if ((one_euro_result.jitter > MAX_JITTER) || (one_euro_result.settle_ms > MAX_SETTLE_MS)) {
+      printf("FAIL: one-euro outside its bounds (jitter %d, settle %.0f ms)\n", MAX_JITTER, MAX_SETTLE_MS);
+      pass = false;
+    }
+    if (one_euro_result.lag > ema_result.lag) {
+      printf("FAIL: one-euro lags further behind than the EMA\n");
+      pass = false;
+    }
+    if ((ema_result.jitter > 0) && (one_euro_result.jitter >= ema_result.jitter)) {
+      printf("FAIL: one-euro jitters as much as the EMA\n");
+      pass = false;
+    }
+  }
+
+  return pass ? 0 : 1;
+
+}
@@ -0,0 +1,44 @@
+#ifndef INCLUDED_HostArduino_ALREADY
+
+// Just enough of Arduino.h for firmware modules to build on the PC (see Makefile).
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef uint8_t byte;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define PROGMEM
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+// a test that uses these provides them
+unsigned long micros();
+
+// interrupts, for code that holds them off (save SREG, noInterrupts(), restore SREG): a test that uses them provides
+// hostSetInterrupts and hostInterruptsEnabled (e.g. blocking and unblocking the signal that stands in for the interrupt)
+void hostSetInterrupts(bool enabled);
+bool hostInterruptsEnabled();
+
+// SREG reads as its I bit (interrupts enabled), and writing it back sets them as they were
+struct host_sreg_s {
+  operator uint8_t() const {
+    return hostInterruptsEnabled() ? 0x80 : 0;
+  }
+  host_sreg_s &operator=(uint8_t value) {
+    hostSetInterrupts(value & 0x80);
+    return *this;
+  }
+};
+#define SREG (host_sreg_s())
+
+inline void noInterrupts() {
+  hostSetInterrupts(false);
+}
+
+inline void interrupts() {
+  hostSetInterrupts(true);
+}
+
+#define INCLUDED_HostArduino_ALREADY
+#endif
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+
+# Writes the pedal traces in traces/ that one-euro-test reads: time_us,adc,truth per line (truth: the noiseless position).
+#
+# They're synthetic, modelled on the external pedal input: ADC noise of about +/-1 count with the odd 2-3 count spike,
+# and the loop's uneven pace (a reading every 1 ms or so, now and then a few ms late behind a packet).
+# Swap in captures from a real device (same columns; truth = your best guess, e.g. the settled value) to test against those.
+#
+#   python3 make_traces.py      (seeded: the same traces every time)
+
+import math
+import random
+
+random.seed(1)
+
+def write(name, segments):
+    # segments: (duration_ms, from, to[, shape]); a move is a raised cosine from 'from' to 'to', or 'linear'
+    # (a foot that runs the pedal into its stop)
+    t = 0.0
+    lines = []
+    start = 0.0
+    for duration, a, b, *shape in segments:
+        end = start + duration * 1000
+        while t < end:
+            x = (t - start) / (end - start)
+            truth = a + (b - a) * (x if shape == ['linear'] else (1 - math.cos(math.pi * x)) / 2)
+            noise = round(random.gauss(0, 0.6))
+            if random.random() < 0.01:
+                noise += random.choice([-3, -2, 2, 3])
+            adc = min(1023, max(0, round(truth) + noise))
+            lines.append('%d,%d,%.1f' % (t, adc, truth))
+            t += random.uniform(800, 1600) if random.random() > 0.02 else random.uniform(3000, 6000)
+        start = end
+    with open('traces/' + name + '.csv', 'w') as f:
+        f.write('time_us,adc,truth\n')
+        f.write('\n'.join(lines) + '\n')
+
+# at rest, mid-travel
+write('rest', [(3000, 512, 512)])
+
+# a slow swell: toe down over a second and a half, and hold
+write('slow_sweep', [(500, 100, 100), (1500, 100, 900), (1000, 900, 900)])
+
+# rocking a wah: heel to toe and back in 150 ms each, into the stops, a few times, then hold
+write('wah_rock', [(500, 200, 200)]
+      + [(150, 200, 850, 'linear'), (100, 850, 850), (150, 850, 200, 'linear'), (100, 200, 200)] * 4
+      + [(1000, 200, 200)])
@@ -0,0 +1,101 @@
+// Device-bridge clock synchronisation, NTP style.
+//
+// The bridge sends /stompbox/sync t1; the device answers /stompbox/sync/reply t1 t2 t3,
+// and the bridge notes t4 when the reply arrives. All four are microsecond clocks,
+// 32 bits wide (the device's micros() wraps every 71 minutes), so all arithmetic here is modulo 2^32.
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2      (device clock minus bridge clock)
+//   delay  = (t4 - t1) - (t3 - t2)            (round trip, minus the device's own turnaround)
+//
+// Samples with the least delay are the least disturbed by queueing, so the estimate is a
+// least-squares line (offset vs. bridge time: intercept and drift) through the low-delay samples.
+
+const u32 = (x) => x >>> 0;     // wrap to unsigned 32-bit
+const s32 = (x) => x | 0;       // wrap to signed 32-bit (for differences)
+
+class ClockSync {
+    constructor(windowSize = 16) {
+        this.windowSize = windowSize;
+        this.samples = [];      // { time: bridge time, offset: relative to this.base, delay }
+        this.base = null;       // first offset seen (mod 2^32); later offsets are kept relative to it
+        this.time0 = 0;
+        this.intercept = 0;
+        this.slope = 0;
+    }
+
+    // bridge clock, in microseconds
+    static now() {
+        return Number(process.hrtime.bigint() / 1000n);
+    }
+
+    get synced() {
+        return this.base !== null;
+    }
+
+    // drift of the device clock relative to ours, parts per million
+    get drift() {
+        return this.slope * 1e6;
+    }
+
+    // make a t1 for a sync request
+    request() {
+        return u32(ClockSync.now());
+    }
+
+    // take a sync reply; returns this exchange's one-way legs (µs) as judged by the updated estimate
+    reply(t1, t2, t3, now = ClockSync.now()) {
+        t1 = u32(t1); t2 = u32(t2); t3 = u32(t3);
+        let t4 = u32(now);
+
+        let delay = s32(t4 - t1) - s32(t3 - t2);
+        let a = u32(t2 - t1);
+        let b = u32(t3 - t4);
+        let offset = u32(a + Math.trunc(s32(b - a) / 2));
+
+        if (this.base === null) {
+            this.base = offset;
+            this.time0 = now;
+        }
+        this.samples.push({ time: now - s32(t4 - t1) / 2, offset: s32(offset - this.base), delay: delay });
+        if (this.samples.length > this.windowSize)
+            this.samples.shift();
+        this.fit();
+
+        let estimate = this.offsetAt(now);
+        return {
+            offset: estimate,
+            delay: delay,
+            bridgeToDevice: s32(t2 - estimate - t1),
+            deviceToBridge: s32(t4 - (t3 - estimate))
+        };
+    }
+
+    fit() {
+        let minDelay = Math.min(...this.samples.map(sample => sample.delay));
+        let good = this.samples.filter(sample => sample.delay <= minDelay + Math.max(500, minDelay / 2));
+        let n = good.length;
+        let meanT = good.reduce((sum, sample) => sum + (sample.time - this.time0), 0) / n;
+        let meanO = good.reduce((sum, sample) => sum + sample.offset, 0) / n;
+        let stt = 0, sto = 0;
+        good.forEach(sample => {
+            let dt = sample.time - this.time0 - meanT;
+            stt += dt * dt;
+            sto += dt * (sample.offset - meanO);
+        });
+        this.slope = (n > 1 && stt > 0) ? sto / stt : 0;
+        this.intercept = meanO - this.slope * meanT;
+    }
+
+    // estimated offset (device minus bridge, mod 2^32) at a given bridge time
+    offsetAt(time) {
+        return u32(this.base + Math.round(this.intercept + this.slope * (time - this.time0)));
+    }
+
+    // bridge time of a (recent) device timestamp
+    deviceToBridge(deviceTime, now = ClockSync.now()) {
+        let estimate = u32(u32(deviceTime) - this.offsetAt(now));
+        return now - s32(u32(now) - estimate);
+    }
+}
+
+module.exports = { ClockSync };
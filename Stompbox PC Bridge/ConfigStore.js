@@ -0,0 +1,56 @@
+// Backup of the device's configuration (its /stompbox/config blob), kept in a local file.
+//
+// The device only holds its configuration in RAM: a reset or reflash puts it back to the firmware defaults.
+// We keep the last configuration it reported, and the few before that (file.1 is the newest of those), so a
+// fresh device can be brought back to where it was, and a bad change can be undone by hand.
+//
+// File format (JSON): { format: 1, saved: <ISO date>, config: <blob as hex> }
+
+const fs = require('fs');
+
+const FORMAT = 1;
+const LAYOUT_BYTES = 5;          // the blob's header: config version and the firmware's counts (see Stompbox.ino)
+
+class ConfigStore {
+    constructor(path, keep = 5) {
+        this.path = path;
+        this.keep = keep;                 // older versions kept alongside
+        this.config = this.load();        // the saved configuration (a Buffer), or null
+    }
+
+    load() {
+        try {
+            let file = JSON.parse(fs.readFileSync(this.path, 'utf8'));
+            if (file.format != FORMAT || typeof file.config != 'string')
+                return null;
+            return Buffer.from(file.config, 'hex');
+        } catch (err) {
+            return null;
+        }
+    }
+
+    // does this configuration differ from the saved one?
+    differs(config) {
+        return !this.config || !this.config.equals(config);
+    }
+
+    // could the saved configuration be pushed to firmware that reports this one? (same version and counts)
+    fits(config) {
+        return this.config != null && config.length == this.config.length
+            && this.config.subarray(0, LAYOUT_BYTES).equals(config.subarray(0, LAYOUT_BYTES));
+    }
+
+    // save a configuration, moving the previous ones down the line
+    save(config) {
+        for (let ii = this.keep - 1; ii >= 0; ii--) {
+            let from = (ii == 0) ? this.path : `${this.path}.${ii}`;
+            if (fs.existsSync(from))
+                fs.renameSync(from, `${this.path}.${ii + 1}`);
+        }
+        let file = { format: FORMAT, saved: new Date().toISOString(), config: config.toString('hex') };
+        fs.writeFileSync(this.path, JSON.stringify(file, null, 2) + '\n');
+        this.config = Buffer.from(config);
+    }
+}
+
+module.exports = { ConfigStore };
@@ -0,0 +1,50 @@
+// Rolling latency samples per named leg, with a percentile summary.
+
+class LatencyStats {
+    constructor(capacity = 1000) {
+        this.capacity = capacity;
+        this.legs = new Map();
+    }
+
+    record(leg, microseconds) {
+        let samples = this.legs.get(leg);
+        if (!samples) {
+            samples = [];
+            this.legs.set(leg, samples);
+        }
+        samples.push(microseconds);
+        if (samples.length > this.capacity)
+            samples.shift();
+    }
+
+    // { leg: { count, min, p50, p95, p99, max } }, in microseconds
+    summary() {
+        let result = {};
+        this.legs.forEach((samples, leg) => {
+            if (samples.length == 0)
+                return;
+            let sorted = samples.slice().sort((a, b) => a - b);
+            let at = (p) => sorted[Math.min(sorted.length - 1, Math.floor(p * sorted.length))];
+            result[leg] = {
+                count: sorted.length,
+                min: sorted[0],
+                p50: at(0.50),
+                p95: at(0.95),
+                p99: at(0.99),
+                max: sorted[sorted.length - 1]
+            };
+        });
+        return result;
+    }
+
+    report(log = console.log) {
+        let summary = this.summary();
+        Object.keys(summary).forEach(leg => {
+            let s = summary[leg];
+            let ms = (us) => (us / 1000).toFixed(2);
+            log(`  ${leg.padEnd(24)} n=${String(s.count).padStart(4)}  min ${ms(s.min)}  p50 ${ms(s.p50)}  p95 ${ms(s.p95)}  p99 ${ms(s.p99)}  max ${ms(s.max)} ms`);
+        });
+    }
+}
+
+module.exports = { LatencyStats };
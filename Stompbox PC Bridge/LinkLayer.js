@@ -0,0 +1,99 @@
+// Link layer between bridge and device, inside the SLIP framing: a sequence number and a CRC per packet,
+// with counts of what went missing, arrived damaged, or arrived out of order. (Same format as StompboxLink.h.)
+//
+// A framed packet is FRAME, a sequence number (one byte, counting up per packet, each way), the OSC packet,
+// then CRC-16/CCITT-FALSE (big-endian) of everything before it. Plain OSC packets start with '#' or '/',
+// so either kind can arrive at any time. We frame ours once we've seen a framed packet from the device
+// (so older firmware never gets one); the device frames its own once asked (/stompbox/link 1).
+
+const FRAME = 0x01;
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, from 0xFFFF, no reflection
+function crc16(buffer, length = buffer.length) {
+    let crc = 0xFFFF;
+    for (let ii = 0; ii < length; ii++) {
+        crc ^= buffer[ii] << 8;
+        for (let bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+    }
+    return crc;
+}
+
+class LinkLayer {
+    constructor() {
+        this.framing = false;             // framing our packets? (the device has shown it understands them)
+        this.txSeq = 0;
+        this.synced = false;              // has a framed packet set where the device's sequence is?
+        this.rxNext = 0;                  // the sequence number we expect next
+        this.corruptSince = 0;            // corrupt packets since the last intact one (they account for that much of a gap)
+        this.stats = { received: 0, lost: 0, corrupt: 0, reordered: 0, sent: 0 };
+    }
+
+    // a packet to send: framed, if the device takes them
+    frame(packet) {
+        if (!this.framing)
+            return packet;
+        let out = Buffer.alloc(packet.length + 4);
+        out[0] = FRAME;
+        out[1] = this.txSeq;
+        this.txSeq = (this.txSeq + 1) & 0xFF;
+        packet.copy(out, 2);
+        out.writeUInt16BE(crc16(out, packet.length + 2), packet.length + 2);
+        this.stats.sent++;
+        return out;
+    }
+
+    // a packet received: its OSC contents, or null if it's damaged (counted)
+    unframe(packet) {
+        if (packet[0] != FRAME) {
+            // the device isn't framing (it's new, or was reset): its sequence starts afresh when it does
+            this.synced = false;
+            return packet;
+        }
+        this.framing = true;
+
+        let length = packet.length - 4;
+        if (length < 0 || crc16(packet, packet.length - 2) != packet.readUInt16BE(packet.length - 2)) {
+            this.stats.corrupt++;
+            this.corruptSince++;
+            return null;
+        }
+
+        // where does it fall in the sequence?
+        this.stats.received++;
+        let seq = packet[1];
+        let gap = ((seq - this.rxNext + 128) & 0xFF) - 128;
+        if (!this.synced) {
+            this.synced = true;
+        } else if (gap < 0) {
+            // late: it was counted lost when the gap it left appeared
+            this.stats.reordered++;
+            if (this.stats.lost > 0)
+                this.stats.lost--;
+            return packet.subarray(2, 2 + length);
+        } else if (gap > this.corruptSince) {
+            this.stats.lost += gap - this.corruptSince;
+        }
+        this.rxNext = (seq + 1) & 0xFF;
+        this.corruptSince = 0;
+        return packet.subarray(2, 2 + length);
+    }
+
+    // one line per direction: bridge->device from the device's counts (received, lost, corrupt, reordered, sent), and ours
+    report(device, log = console.log) {
+        let line = (label, sent, s) => {
+            let total = s.received + s.lost + s.corrupt;
+            let bad = total ? ((s.lost + s.corrupt) * 100 / total).toFixed(2) : '0.00';
+            log(`  ${label.padEnd(24)} sent ${String(sent).padStart(6)}  received ${String(s.received).padStart(6)}`
+                + `  lost ${s.lost}  corrupt ${s.corrupt}  reordered ${s.reordered}  (${bad}% bad)`);
+        };
+        if (!this.framing) {
+            log('  link: device isn\'t framing (yet)');
+            return;
+        }
+        line('link: bridge->device', this.stats.sent, device);
+        line('link: device->bridge', device.sent, this.stats);
+    }
+}
+
+module.exports = { LinkLayer, crc16 };
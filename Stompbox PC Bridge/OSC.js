@@ -0,0 +1,145 @@
+// OSC 1.0 - just enough of it for the bridge to talk to the Stompbox itself,
+// and to look inside the packets it passes along.
+// (int32, float32, string and blob arguments; bundles one level deep.)
+
+const BUNDLE_TAG = '#bundle';
+
+function padded(length) {
+    return (length + 3) & ~3;
+}
+
+function encodeString(str) {
+    let buffer = Buffer.alloc(padded(Buffer.byteLength(str) + 1));
+    buffer.write(str);
+    return buffer;
+}
+
+function encodeBlob(blob) {
+    let buffer = Buffer.alloc(4 + padded(blob.length));
+    buffer.writeUInt32BE(blob.length, 0);
+    Buffer.from(blob).copy(buffer, 4);
+    return buffer;
+}
+
+// args: array of { type: 'i' | 'f' | 's' | 'b', value }
+function encodeMessage(address, args = []) {
+    let parts = [encodeString(address), encodeString(',' + args.map(arg => arg.type).join(''))];
+    args.forEach(arg => {
+        let part;
+        switch (arg.type) {
+            case 'i':
+                part = Buffer.alloc(4);
+                part.writeInt32BE(arg.value | 0, 0);
+                break;
+            case 'f':
+                part = Buffer.alloc(4);
+                part.writeFloatBE(arg.value, 0);
+                break;
+            case 's':
+                part = encodeString(arg.value);
+                break;
+            case 'b':
+                part = encodeBlob(arg.value);
+                break;
+            default:
+                throw new Error(`OSC: unsupported argument type '${arg.type}'`);
+        }
+        parts.push(part);
+    });
+    return Buffer.concat(parts);
+}
+
+function readString(buffer, offset) {
+    let end = buffer.indexOf(0, offset);
+    if (end < 0)
+        return null;
+    return { value: buffer.toString('latin1', offset, end), next: offset + padded(end - offset + 1) };
+}
+
+// returns { address, args: [{ type, value }] }, or null if the packet isn't a well-formed message
+function decodeMessage(buffer) {
+    let address = readString(buffer, 0);
+    if (!address || address.value[0] != '/')
+        return null;
+    let tags = readString(buffer, address.next);
+    if (!tags || tags.value[0] != ',')
+        return { address: address.value, args: [] };
+    let offset = tags.next;
+    let args = [];
+    for (let type of tags.value.slice(1)) {
+        // int, float and blob each start with 4 bytes: a truncated packet stops here, rather than reading past its end
+        if ('ifb'.includes(type) && offset + 4 > buffer.length)
+            return null;
+        switch (type) {
+            case 'i':
+                args.push({ type, value: buffer.readInt32BE(offset) });
+                offset += 4;
+                break;
+            case 'f':
+                args.push({ type, value: buffer.readFloatBE(offset) });
+                offset += 4;
+                break;
+            case 's': {
+                let str = readString(buffer, offset);
+                if (!str)
+                    return null;
+                args.push({ type, value: str.value });
+                offset = str.next;
+                break;
+            }
+            case 'b': {
+                let length = buffer.readUInt32BE(offset);
+                if (offset + 4 + length > buffer.length)
+                    return null;
+                args.push({ type, value: buffer.subarray(offset + 4, offset + 4 + length) });
+                offset += 4 + padded(length);
+                break;
+            }
+            default:
+                // types we don't read carry no data (T, F, N, I) or we give up on the rest
+                args.push({ type, value: null });
+        }
+    }
+    return { address: address.value, args };
+}
+
+function isBundle(buffer) {
+    return buffer.length >= 16 && buffer.toString('latin1', 0, 7) == BUNDLE_TAG && buffer[7] == 0;
+}
+
+// returns { seconds, fraction, elements: [Buffer] }, or null if the packet isn't a well-formed bundle
+function decodeBundle(buffer) {
+    if (!isBundle(buffer))
+        return null;
+    let seconds = buffer.readUInt32BE(8);
+    let fraction = buffer.readUInt32BE(12);
+    let elements = [];
+    let offset = 16;
+    while (offset + 4 <= buffer.length) {
+        let size = buffer.readUInt32BE(offset);
+        if (offset + 4 + size > buffer.length)
+            return null;
+        elements.push(buffer.subarray(offset + 4, offset + 4 + size));
+        offset += 4 + size;
+    }
+    return { seconds, fraction, elements };
+}
+
+function encodeBundle(seconds, fraction, elements) {
+    let header = Buffer.alloc(16);
+    header.write(BUNDLE_TAG);
+    header.writeUInt32BE(seconds >>> 0, 8);
+    header.writeUInt32BE(fraction >>> 0, 12);
+    let parts = [header];
+    elements.forEach(element => {
+        let size = Buffer.alloc(4);
+        size.writeUInt32BE(element.length, 0);
+        parts.push(size, element);
+    });
+    return Buffer.concat(parts);
+}
+
+// timetag meaning "immediately"
+const IMMEDIATE = { seconds: 0, fraction: 1 };
+
+module.exports = { encodeMessage, decodeMessage, isBundle, decodeBundle, encodeBundle, IMMEDIATE };
@@ -0,0 +1,78 @@
+// Beat/bar quantisation of stomps, from Reaper's transport feedback.
+//
+// Reaper reports tempo (/tempo/raw) and play position (/beat/str, "measure.beat.hundredths") as it plays.
+// Each position report, less its truncation, fixes where beat zero falls on the bridge clock; averaging
+// a window of them dithers away the 1/100-beat resolution. From that line we can say when the next
+// beat (or bar) boundary will come, and hold a stomp until just before it.
+
+const WINDOW = 32;               // position reports averaged
+const RESYNC_BEATS = 0.1;        // a report this far off the line means a seek, loop or tempo ramp: start over
+
+class Quantiser {
+    constructor(mode = 'beat', beatsPerBar = 4) {
+        this.mode = mode;                 // 'off', 'beat' or 'bar'
+        this.beatsPerBar = beatsPerBar;
+        this.bpm = 0;
+        this.isPlaying = false;
+        this.anchors = [];                // beat position at bridge time zero, per report
+    }
+
+    get enabled() {
+        return this.mode == 'beat' || this.mode == 'bar';
+    }
+
+    // tempo changed: positions so far were on a different line
+    tempo(bpm) {
+        if (bpm != this.bpm)
+            this.anchors = [];
+        this.bpm = bpm;
+    }
+
+    playing(isPlaying) {
+        if (isPlaying != this.isPlaying)
+            this.anchors = [];
+        this.isPlaying = isPlaying;
+    }
+
+    // a position report, received at bridge time 'now' (µs)
+    beat(str, now) {
+        let parts = str.split('.').map(Number);
+        if (parts.length < 2 || parts.some(isNaN) || this.bpm <= 0)
+            return;
+        let [measure, beat, hundredths = 0] = parts;
+        // Reaper truncates to hundredths: add half a step to centre the error
+        let position = (measure - 1) * this.beatsPerBar + (beat - 1) + (hundredths + 0.5) / 100;
+        let anchor = position - now * this.beatsPerMicrosecond;
+
+        if (this.anchors.length > 0 && Math.abs(anchor - this.anchor) > RESYNC_BEATS)
+            this.anchors = [];
+        this.anchors.push(anchor);
+        if (this.anchors.length > WINDOW)
+            this.anchors.shift();
+    }
+
+    get beatsPerMicrosecond() {
+        return this.bpm / 60e6;
+    }
+
+    get anchor() {
+        return this.anchors.reduce((sum, anchor) => sum + anchor, 0) / this.anchors.length;
+    }
+
+    // beat position (0-based, in beats) at bridge time 'now'
+    position(now) {
+        return this.anchor + now * this.beatsPerMicrosecond;
+    }
+
+    // bridge time (µs) of the next boundary at least 'lead' µs away, or null if we can't say (stopped, or no tempo yet)
+    nextBoundary(now, lead = 0) {
+        if (!this.enabled || !this.isPlaying || this.bpm <= 0 || this.anchors.length == 0)
+            return null;
+        let grid = (this.mode == 'bar') ? this.beatsPerBar : 1;
+        let earliest = this.position(now + lead);
+        let boundary = Math.ceil(earliest / grid) * grid;
+        return now + (boundary - this.position(now)) / this.beatsPerMicrosecond;
+    }
+}
+
+module.exports = { Quantiser };
@@ -18,7 +18,8 @@ class SLIPParser {
             let length = this.index;
             this.index = 0;
             this.prevESC = false;
-            this.result = Buffer.from(this.buffer.buffer, 0, length);
+            // copy: the caller may still be sending the previous packet (asynchronously) when we start on the next one
+            this.result = Buffer.from(this.buffer.subarray(0, length));
             return length;
         } else if (byte == ESC) {
             this.prevESC = true;
@@ -0,0 +1,541 @@
+#!/usr/bin/env node
+
+// Stompbox PC Bridge load benchmark
+//
+// Stands in for Reaper (on UDP) and for the Stompbox (on a pseudo-terminal), runs the real bridge (main.js)
+// between them, and drives synthetic OSC traffic through it at stepped rates, to find out how much
+// the bridge can carry in each direction before messages arrive late or not at all.
+// With --quantise, it instead plays a steady tempo as Reaper's transport and checks that stomps land on the beat.
+// With --midi, it also sends the MIDI build's messages through an ALSA virtual MIDI port, timed the same way, to set
+// the MIDI transport's PC-side hop against the OSC one.
+
+/*
+  Usage:
+
+        node bench.js [--direction up|down|both] [--rates 50,100,...] [--size bytes] [--burst n] [--seconds s] [--max-p99 ms]
+
+    up: device -> bridge -> Reaper.  down: Reaper -> bridge -> device.
+
+    --size is the size of each OSC message in bytes (rounded up to OSC's 4-byte grid; 24 minimum, 1000 maximum).
+    --burst n sends the messages in back-to-back groups of n, at the same average rate (1 = evenly spaced).
+    --seconds is how long each rate step runs.
+
+    A rate counts as sustained when nothing was dropped or duplicated, at least 95% of the offered rate got through,
+    and p99 latency stayed under --max-p99.
+
+        node bench.js --quantise beat|bar [--tempo bpm] [--stomps n]
+
+    Runs the bridge quantising, with "Reaper" playing at --tempo (reporting its position every ~30 ms, as Reaper does),
+    and "the device" stomping n times at random moments, each stomp two messages 10 ms apart (as the S&M bypass toggle is).
+    Reports how far from the boundary each stomp landed, and counts stomps that came apart, landed on a later boundary
+    than the first one they could have made, or leaked transport feedback to the device.
+
+        node bench.js --midi out,in [--rates 50,100,...] [--burst n] [--seconds s] [--max-p99 ms]
+
+    Writes each message as the MIDI build would send it (MIDIOutput::setFxParam: a 14-bit NRPN, four control changes,
+    12 bytes) to the raw MIDI device 'out', and times its arrival at the raw MIDI device 'in'; then runs the OSC build's
+    'up' direction (device -> bridge -> Reaper, over the pseudo-terminal and UDP) at the same rates, for comparison.
+    For the ports, load snd-virmidi and connect two of its ports through the ALSA sequencer, e.g.:
+
+        sudo modprobe snd-virmidi midi_devs=2
+        aconnect -l                       (find the "Virtual Raw MIDI" clients: say 20:0 and 21:0, on card 1)
+        aconnect 20:0 21:0
+        node bench.js --midi /dev/snd/midiC1D0,/dev/snd/midiC1D1
+
+    These are the PC's legs only (the USB hop and the firmware are the same either way, or near enough):
+    in the MIDI build, Reaper reads the device's ALSA port directly; in the OSC build, the bridge reads the serial port
+    and relays over UDP.
+
+  Dependencies:
+
+    python3, for the pseudo-terminal (the stand-in device's end of the serial link)
+    the bridge's own dependencies (node-serialport)
+    for --midi, ALSA with the snd-virmidi module (and aconnect, from alsa-utils)
+*/
+
+const { spawn } = require('child_process');
+const dgram = require('dgram');
+const fs = require('fs');
+const path = require('path');
+
+const SLIP = require('./SLIP.js');
+const OSC = require('./OSC.js');
+const { LatencyStats } = require('./LatencyStats.js');
+
+const bridgePort = 18888; // bridge's local port: where "Reaper" sends
+const reaperPort = 19999; // bridge's remote port: where "Reaper" listens
+
+const drainTime = 1000; // ms to wait after each step for stragglers
+const sustainedFraction = 0.95;
+
+// ------------ options ------------ //
+//#region options
+
+let options = {
+    direction: 'both',
+    rates: [50, 100, 200, 500, 1000, 2000, 5000],
+    size: 40,
+    burst: 1,
+    seconds: 3,
+    maxP99: 20,
+    quantise: null,
+    tempo: 120,
+    stomps: 20,
+    midi: null,
+};
+
+for (let ii = 2; ii < process.argv.length; ii += 2) {
+    let value = process.argv[ii + 1];
+    switch (process.argv[ii]) {
+        case '--direction': options.direction = value; break;
+        case '--rates': options.rates = value.split(',').map(Number); break;
+        case '--size': options.size = parseInt(value); break;
+        case '--burst': options.burst = Math.max(1, parseInt(value)); break;
+        case '--seconds': options.seconds = parseFloat(value); break;
+        case '--max-p99': options.maxP99 = parseFloat(value); break;
+        case '--quantise': options.quantise = value; break;
+        case '--tempo': options.tempo = parseFloat(value); break;
+        case '--stomps': options.stomps = parseInt(value); break;
+        case '--midi': options.midi = value.split(','); break;
+        default:
+            console.error(`unknown option ${process.argv[ii]}`);
+            process.exit(1);
+    }
+}
+
+options.size = Math.min(1000, Math.max(24, (options.size + 3) & ~3));
+if (options.midi && options.midi.length != 2) {
+    console.error('--midi wants two raw MIDI devices: out,in');
+    process.exit(1);
+}
+
+//#endregion
+
+const now = () => Number(process.hrtime.bigint() / 1000n); // µs
+
+// ------------ stand-in device ------------ //
+//#region device
+
+// python holds the pseudo-terminal open: the bridge opens the slave side like any serial port,
+// and python relays the master side to and from our stdin/stdout.
+const PTY_RELAY = `
+import os, pty, select, sys, tty
+master, slave = pty.openpty()
+tty.setraw(slave)
+sys.stdout.write(os.ttyname(slave) + "\\n")
+sys.stdout.flush()
+while True:
+    ready, _, _ = select.select([master, 0], [], [])
+    if master in ready:
+        os.write(1, os.read(master, 65536))
+    if 0 in ready:
+        data = os.read(0, 65536)
+        if not data:
+            break
+        os.write(master, data)
+`;
+
+let relay;
+let ptyName = null;
+const deviceParser = new SLIP.SLIPParser;
+const deviceEncoder = new SLIP.SLIPEncoder;
+let onDevicePacket = () => {};
+
+function startDevice() {
+    return new Promise((resolve, reject) => {
+        relay = spawn('python3', ['-c', PTY_RELAY], { stdio: ['pipe', 'pipe', 'inherit'] });
+        relay.on('error', reject);
+        let pending = Buffer.alloc(0);
+        relay.stdout.on('data', (data) => {
+            if (ptyName === null) {
+                pending = Buffer.concat([pending, data]);
+                let newline = pending.indexOf(10);
+                if (newline < 0)
+                    return;
+                ptyName = pending.toString('latin1', 0, newline);
+                data = pending.subarray(newline + 1);
+                resolve(ptyName);
+            }
+            for (let ii = 0; ii < data.length; ii++) {
+                if (deviceParser.parse(data[ii]) > 0)
+                    onDevicePacket(Buffer.from(deviceParser.message));
+            }
+        });
+    });
+}
+
+function deviceSend(packet) {
+    deviceEncoder.encode(packet);
+    relay.stdin.write(Buffer.from(deviceEncoder.message));
+}
+
+//#endregion
+
+// ------------ stand-in Reaper ------------ //
+//#region reaper
+
+const reaper = dgram.createSocket('udp4');
+let onReaperPacket = () => {};
+reaper.on('message', (message) => onReaperPacket(message));
+
+function reaperSend(packet) {
+    reaper.send(packet, bridgePort, '127.0.0.1');
+}
+
+//#endregion
+
+// ------------ virtual MIDI port ------------ //
+//#region midi
+
+// as in StompboxMIDI.h and .cpp: channel 1, NRPN select and data entry controllers
+const MIDI_STATUS_CONTROL_CHANGE = 0xB0;
+const CC_NRPN_MSB = 99;
+const CC_NRPN_LSB = 98;
+const CC_DATA_ENTRY_MSB = 6;
+const CC_DATA_ENTRY_LSB = 38;
+const MIDI_MESSAGE_SIZE = 12; // one NRPN: four control changes, status byte and all
+
+// python reads the MIDI input and relays it to our stdin, as with the pseudo-terminal: a read on a MIDI device
+// only returns with data, and one left waiting in node's own thread pool would keep the benchmark from exiting.
+const MIDI_RELAY = `
+import os, sys
+port = os.open(sys.argv[1], os.O_RDONLY)
+sys.stdout.write("open\\n")
+sys.stdout.flush()
+while True:
+    os.write(1, os.read(port, 256))
+`;
+
+let midiRelay;
+let midiOutput = null; // fd
+let onMidiSeq = () => {};
+
+function startMidi() {
+    // open the reading end first: once it's open, opening the writing end can't wait on it
+    return new Promise((resolve, reject) => {
+        midiRelay = spawn('python3', ['-c', MIDI_RELAY, options.midi[1]], { stdio: ['ignore', 'pipe', 'inherit'] });
+        midiRelay.on('error', reject);
+        midiRelay.on('exit', (code) => {
+            if (midiOutput === null)
+                reject(new Error(`can't read ${options.midi[1]}`));
+        });
+        let opened = false;
+        // control changes only, with running status (the sequencer may or may not use it); NRPNs as the firmware
+        // takes them (dispatchControlChange), the data entry LSB completing one
+        let status = 0, data = [];
+        let nrpn = [0, 0, 0];
+        midiRelay.stdout.on('data', (bytes) => {
+            if (!opened) {
+                opened = true;
+                bytes = bytes.subarray(bytes.indexOf(10) + 1);
+                midiOutput = fs.openSync(options.midi[0], 'w');
+                resolve();
+            }
+            for (let byte of bytes) {
+                if (byte >= 0xF8)
+                    continue; // real-time, can come between anything
+                if (byte & 0x80) {
+                    status = byte;
+                    data = [];
+                    continue;
+                }
+                if ((status & 0xF0) != MIDI_STATUS_CONTROL_CHANGE)
+                    continue;
+                data.push(byte);
+                if (data.length < 2)
+                    continue;
+                let [control, value] = data;
+                data = [];
+                if (control == CC_NRPN_MSB)
+                    nrpn[0] = value;
+                else if (control == CC_NRPN_LSB)
+                    nrpn[1] = value;
+                else if (control == CC_DATA_ENTRY_MSB)
+                    nrpn[2] = value;
+                else if (control == CC_DATA_ENTRY_LSB)
+                    onMidiSeq((nrpn[0] << 21) | (nrpn[1] << 14) | (nrpn[2] << 7) | value);
+            }
+        });
+    });
+}
+
+/// MIDIOutput::setFxParam's NRPN, carrying a sequence number (28 bits) in place of fx, param and value
+function midiSend(seq) {
+    let message = Buffer.from([
+        MIDI_STATUS_CONTROL_CHANGE, CC_NRPN_MSB, (seq >> 21) & 0x7F,
+        MIDI_STATUS_CONTROL_CHANGE, CC_NRPN_LSB, (seq >> 14) & 0x7F,
+        MIDI_STATUS_CONTROL_CHANGE, CC_DATA_ENTRY_MSB, (seq >> 7) & 0x7F,
+        MIDI_STATUS_CONTROL_CHANGE, CC_DATA_ENTRY_LSB, seq & 0x7F
+    ]);
+    fs.writeSync(midiOutput, message);
+}
+
+//#endregion
+
+// ------------ bridge ------------ //
+//#region bridge
+
+let bridge;
+
+function startBridge() {
+    let args = [path.join(__dirname, 'main.js'), bridgePort, reaperPort, '127.0.0.1', ptyName];
+    if (options.quantise)
+        args.push(options.quantise, BEATS_PER_BAR);
+    bridge = spawn(process.execPath, args, { stdio: ['ignore', 'inherit', 'inherit'] });
+    // the bridge says hello to the device (clock sync) as soon as it has the port open
+    return new Promise((resolve) => {
+        onDevicePacket = (packet) => {
+            let message = OSC.decodeMessage(packet);
+            if (message && message.address.startsWith('/stompbox/')) {
+                onDevicePacket = () => {};
+                resolve();
+            }
+        };
+    });
+}
+
+//#endregion
+
+// ------------ quantise ------------ //
+//#region quantise
+
+const BEATS_PER_BAR = 4;
+const POSITION_INTERVAL = 30; // ms between "Reaper" position reports (jittered +/- half)
+const SETTLE_TIME = 2000; // ms of transport before the first stomp
+const STOMP_GATHER = 30; // ms: the bridge's own allowance for a stomp to arrive whole (see main.js)
+
+function runQuantise() {
+
+    let grid = (options.quantise == 'bar') ? BEATS_PER_BAR : 1;
+    let usPerBeat = 60e6 / options.tempo;
+    let start = now();
+    let position = (time) => (time - start) / usPerBeat; // beats since "play"
+
+    // Reaper's transport: tempo and play state once, then position reports as it plays
+    reaperSend(OSC.encodeMessage('/tempo/raw', [{ type: 'f', value: options.tempo }]));
+    reaperSend(OSC.encodeMessage('/play', [{ type: 'f', value: 1 }]));
+    let reportPosition = () => {
+        let beats = position(now());
+        let measure = Math.floor(beats / BEATS_PER_BAR) + 1;
+        let beat = Math.floor(beats % BEATS_PER_BAR) + 1;
+        let hundredths = String(Math.floor((beats % 1) * 100)).padStart(2, '0');
+        reaperSend(OSC.encodeMessage('/beat/str', [{ type: 's', value: `${measure}.${beat}.${hundredths}` }]));
+        positionTimer = setTimeout(reportPosition, POSITION_INTERVAL * (0.5 + Math.random()));
+    };
+    let positionTimer = setTimeout(reportPosition, 0);
+
+    let stats = new LatencyStats(options.stomps);
+    let earliest = new Array(options.stomps); // first boundary each stomp could make
+    let landed = 0, split = 0, late = 0, leaked = 0;
+
+    onDevicePacket = (packet) => {
+        let message = OSC.decodeMessage(packet);
+        if (message && message.address == '/beat/str')
+            leaked++;
+    };
+    onReaperPacket = (packet) => {
+        let time = now();
+        let bundle = OSC.decodeBundle(packet);
+        let messages = (bundle ? bundle.elements : [packet]).map(OSC.decodeMessage).filter(m => m && m.address == '/bench/stomp');
+        if (messages.length == 0)
+            return;
+        // like Reaper, answer with feedback (the bridge measures its turnaround from this)
+        reaperSend(OSC.encodeMessage('/bench/feedback'));
+        let beats = position(time);
+        let boundary = Math.round(beats / grid) * grid;
+        // stomps close together share a boundary, and a bundle; each should be there whole
+        let counts = new Map();
+        messages.forEach(m => counts.set(m.args[0].value, (counts.get(m.args[0].value) || 0) + 1));
+        counts.forEach((count, seq) => {
+            if (count != 2)
+                split++;
+            stats.record('error', Math.abs(beats - boundary) * usPerBeat);
+            if (boundary > earliest[seq])
+                late++;
+            landed++;
+        });
+    };
+
+    return new Promise((resolve) => {
+        let seq = 0;
+        let stomp = () => {
+            let time = now();
+            earliest[seq] = Math.ceil((position(time) + STOMP_GATHER * 1000 / usPerBeat) / grid) * grid;
+            let message = OSC.encodeMessage('/bench/stomp', [{ type: 'i', value: seq }]);
+            deviceSend(OSC.encodeBundle(1, time, [message])); // timetag seconds 1: a stomp, to be held
+            setTimeout(() => deviceSend(OSC.encodeBundle(1, now(), [message])), 10);
+            if (++seq < options.stomps) {
+                setTimeout(stomp, 300 + Math.random() * 600 + Math.random() * usPerBeat * grid / 1000);
+            } else {
+                setTimeout(() => {
+                    clearTimeout(positionTimer);
+                    let summary = stats.summary().error || { p50: 0, p95: 0, p99: 0, max: 0 };
+                    resolve({ landed, split, late, leaked, ...summary });
+                }, usPerBeat * grid / 1000 + drainTime);
+            }
+        };
+        setTimeout(stomp, SETTLE_TIME);
+    });
+}
+
+//#endregion
+
+// ------------ benchmark ------------ //
+//#region benchmark
+
+const ADDRESS = { up: '/bench/up', down: '/bench/down' };
+
+function benchMessage(direction, seq) {
+    // address (12) + tags ",ib" (4) + seq (4) + blob size (4) + padding blob
+    return OSC.encodeMessage(ADDRESS[direction], [
+        { type: 'i', value: seq },
+        { type: 'b', value: Buffer.alloc(options.size - 24) }
+    ]);
+}
+
+function runStep(direction, rate) {
+
+    let total = Math.max(1, Math.round(rate * options.seconds));
+    let sendTimes = new Array(total);
+    let seen = new Uint8Array(total);
+    let stats = new LatencyStats(total);
+    let received = 0, duplicates = 0, reordered = 0, highest = -1;
+    let lastReceive = 0;
+
+    let receiveSeq = (seq) => {
+        let time = now();
+        if (seq < 0 || seq >= total)
+            return;
+        if (seen[seq]) {
+            duplicates++;
+            return;
+        }
+        seen[seq] = 1;
+        if (seq < highest)
+            reordered++;
+        highest = Math.max(highest, seq);
+        lastReceive = time;
+        received++;
+        stats.record(direction, time - sendTimes[seq]);
+    };
+    let receive = (packet) => {
+        let message = OSC.decodeMessage(packet);
+        if (message && message.address == ADDRESS[direction])
+            receiveSeq(message.args[0].value);
+    };
+    let send;
+    onReaperPacket = () => {};
+    onDevicePacket = () => {};
+    onMidiSeq = () => {};
+    if (direction == 'midi') {
+        send = (seq) => midiSend(seq);
+        onMidiSeq = receiveSeq;
+    } else if (direction == 'up') {
+        send = (seq) => deviceSend(benchMessage(direction, seq));
+        onReaperPacket = receive;
+    } else {
+        send = (seq) => reaperSend(benchMessage(direction, seq));
+        onDevicePacket = receive;
+    }
+
+    return new Promise((resolve) => {
+        let start = now();
+        let sent = 0;
+        let timer = setInterval(() => {
+            let elapsed = (now() - start) / 1e6;
+            // each group of 'burst' messages goes out back to back, on the schedule of its first message
+            while (sent < total && sent / rate <= elapsed) {
+                for (let bb = 0; bb < options.burst && sent < total; bb++) {
+                    sendTimes[sent] = now();
+                    send(sent);
+                    sent++;
+                }
+            }
+            if (sent >= total) {
+                clearInterval(timer);
+                setTimeout(() => {
+                    let summary = stats.summary()[direction] || { p50: 0, p95: 0, p99: 0, max: 0 };
+                    let span = (lastReceive - start) / 1e6;
+                    let achieved = (span > 0) ? received / Math.max(span, total / rate) : 0;
+                    resolve({
+                        direction, rate, sent: total, received, dropped: total - received, duplicates, reordered,
+                        achieved, p50: summary.p50, p95: summary.p95, p99: summary.p99, max: summary.max,
+                        sustained: (received == total) && (duplicates == 0) && (achieved >= rate * sustainedFraction) && (summary.p99 / 1000 <= options.maxP99)
+                    });
+                }, drainTime);
+            }
+        }, 1);
+    });
+}
+
+function printResult(r) {
+    let ms = (us) => (us / 1000).toFixed(2).padStart(8);
+    console.log(
+        `${r.direction.padEnd(5)} ${String(r.rate).padStart(6)} ${String(r.sent).padStart(6)} ${String(r.received).padStart(6)}` +
+        ` ${String(r.dropped).padStart(5)} ${String(r.duplicates).padStart(5)} ${String(r.reordered).padStart(5)} ${r.achieved.toFixed(0).padStart(8)}` +
+        ` ${ms(r.p50)} ${ms(r.p95)} ${ms(r.p99)} ${ms(r.max)}  ${r.sustained ? 'ok' : '--'}`);
+}
+
+async function main() {
+
+    if (options.midi)
+        await startMidi();
+    await startDevice();
+    reaper.bind(reaperPort);
+    await startBridge();
+
+    if (options.quantise) {
+        console.log(`- Quantise benchmark: ${options.stomps} stomps to the ${options.quantise} at ${options.tempo} bpm`);
+        let r = await runQuantise();
+        let ms = (us) => (us / 1000).toFixed(2);
+        console.log(`  landed ${r.landed}/${options.stomps}  split ${r.split}  late ${r.late}  leaked ${r.leaked}`);
+        console.log(`  distance from boundary: p50 ${ms(r.p50)}  p95 ${ms(r.p95)}  p99 ${ms(r.p99)}  max ${ms(r.max)} ms`);
+        bridge.kill();
+        relay.kill();
+        reaper.close();
+        return;
+    }
+
+    console.log(`- Bridge benchmark: ${options.size}-byte messages, bursts of ${options.burst}, ${options.seconds} s per step, p99 limit ${options.maxP99} ms`);
+    if (options.midi)
+        console.log(`- MIDI: ${MIDI_MESSAGE_SIZE}-byte NRPNs, ${options.midi[0]} -> ${options.midi[1]}; against the OSC path, up`);
+    console.log('dir     rate   sent   recv  drop   dup  reord  got/s   p50 ms   p95 ms   p99 ms   max ms');
+
+    let directions = (options.direction == 'both') ? ['up', 'down'] : [options.direction];
+    if (options.midi)
+        directions = ['midi', 'up'];
+    let best = {};
+    for (let direction of directions) {
+        best[direction] = 0;
+        for (let rate of options.rates) {
+            let result = await runStep(direction, rate);
+            printResult(result);
+            if (result.sustained)
+                best[direction] = Math.max(best[direction], rate);
+        }
+    }
+
+    console.log('- Max sustained rate:');
+    directions.forEach(direction => {
+        let size = (direction == 'midi') ? MIDI_MESSAGE_SIZE : options.size;
+        console.log(`  ${direction.padEnd(5)} ${best[direction]} msg/s (${(best[direction] * size / 1024).toFixed(1)} KiB/s)`);
+    });
+
+    bridge.kill();
+    relay.kill();
+    reaper.close();
+    if (options.midi) {
+        fs.closeSync(midiOutput);
+        midiRelay.kill();
+    }
+}
+
+main().catch((err) => {
+    console.error(err);
+    if (bridge) bridge.kill();
+    if (relay) relay.kill();
+    if (midiRelay) midiRelay.kill();
+    process.exit(1);
+});
+
+//#endregion
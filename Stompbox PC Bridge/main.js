@@ -15,7 +15,7 @@
 
   Usage:
 
-        node main.js [local-port [remote-port [remote-address]]]
+        node main.js [local-port [remote-port [remote-address [serial-port [quantise [beats-per-bar]]]]]]
 
     If no ports are specified, port 8888 is used for both local port
     and 9999 for remote port). The default remote address is 'localhost'. @#@ changed from original 8888/8888
@@ -35,7 +35,12 @@
 
     The script will automatically look for Arduino or Teensy boards connected
     via USB. If no such board can be find, the first COM port will be selected.
-    You can specify a port to override the search for Arduinos.
+    You can specify a port to override the search for Arduinos,
+    either below (comName) or as the serial-port argument ('' to search).
+
+    quantise is 'off' (the default), 'beat' or 'bar': hold each stomp until the next beat
+    or bar boundary of Reaper's transport, while it's playing. (Needs the BEAT pattern in
+    Stompbox.ReaperOSC.) beats-per-bar defaults to 4.
 
   Dependencies:
 
@@ -52,6 +57,15 @@ let comName;
 // comName = '/dev/ttyUSB0'; // Uncomment this line to select a specific port instead of searching for an Arduino.
 const baudRate = 115200; // 9600; // 115200;
 
+let quantise = 'off'; // 'off', 'beat' or 'bar'
+
+// the device's configuration is backed up here (beside this script) and restored to it after a reset; '' = don't
+const configFile = 'stompbox-config.json';
+
+// frame packets to and from the device with a sequence number and CRC, and count what goes wrong (see LinkLayer.js)
+const linkLayer = true;
+let beatsPerBar = 4;
+
 const defaultLocalPort = 8888;
 const defaultRemotePort = 9999;
 const defaultRemoteAddress = 'localhost';
@@ -71,6 +85,15 @@ let remoteAddr = defaultRemoteAddress;
 if (process.argv.length > 4)
     remoteAddr = process.argv[4];
 
+if (process.argv.length > 5)
+    comName = process.argv[5];
+
+if (process.argv.length > 6)
+    quantise = process.argv[6];
+
+if (process.argv.length > 7)
+    beatsPerBar = parseInt(process.argv[7]);
+
 const dgram = require('dgram');
 const server = dgram.createSocket('udp4');
 
@@ -82,7 +105,11 @@ server.on('error', (err) => {
 server.on('message', (message, rinfo) => {
 	
     remoteAddr = rinfo.address;
-    sendSerial(message);
+    let forward = filterReaperPacket(message);
+    if (forward) {
+        noteReaperPacket(); // (transport feedback streams in regardless, so it says nothing about turnaround)
+        sendSerial(forward);
+    }
 
 	if (verbose >= 3) {
 		console.log(`  -> ${message.join(' ')} (${rinfo.address}:${rinfo.port})`);
@@ -238,6 +265,7 @@ function openPort(comName) {
 	
     // Attach a callback function to handle incomming data
     port.on('data', receiveSerial);
+    port.on('open', startDeviceServices);
 	if (verbose >= 1) {
 		console.log("- Connected to Stompbox");
 	}
@@ -248,8 +276,10 @@ function openPort(comName) {
 // ----------- SLIP ------------ //
 //#region SLIP
 const SLIP = require('./SLIP.js');
+const { LinkLayer } = require('./LinkLayer.js');
 
 const parser = new SLIP.SLIPParser;
+const link = new LinkLayer;
 
 function receiveSerial(dataBuf) {
 
@@ -258,7 +288,12 @@ function receiveSerial(dataBuf) {
         // Parse the byte
         let length = parser.parse(dataBuf[i])
         if (length > 0) {
-            sendUDP(parser.message);
+            let packet = link.unframe(parser.message);
+            if (packet) {
+                receiveDevicePacket(packet);
+            } else if (verbose >= 2) {
+                console.log('- Dropped a damaged packet from the Stompbox');
+            }
         }
     }
 	
@@ -278,8 +313,12 @@ const encoder = new SLIP.SLIPEncoder;
 
 function sendSerial(dataBuf) {
 	
-    // Encode the data using the SLIP protocol
-    encoder.encode(dataBuf);
+	if (!port) {
+		return;
+	}
+
+    // Encode the data using the SLIP protocol (framed first, once the device takes framed packets)
+    encoder.encode(link.frame(dataBuf));
     let out = Buffer.from(encoder.message);
     // Send the encoded data over the Serial port
     port.write(out);
@@ -290,3 +329,493 @@ function sendSerial(dataBuf) {
 }
 
 //#endregion
+
+// --------- Stompbox ---------- //
+//#region Stompbox
+
+// Messages between bridge and device (clock sync, etc.) start with this; they are never passed on to Reaper.
+const DEVICE_PREFIX = '/stompbox/';
+
+const OSC = require('./OSC.js');
+const { ClockSync } = require('./ClockSync.js');
+const { LatencyStats } = require('./LatencyStats.js');
+const { Quantiser } = require('./Quantiser.js');
+const { ConfigStore } = require('./ConfigStore.js');
+
+const clock = new ClockSync;
+const latency = new LatencyStats;
+const quantiser = new Quantiser(quantise, beatsPerBar);
+const configStore = configFile ? new ConfigStore(require('path').join(__dirname, configFile)) : null;
+
+const syncInterval = 2000; // ms between clock sync exchanges
+const latencyReportInterval = 10000; // ms between latency reports (shown at verbose >= 2)
+const configInterval = 5000; // ms between checks of the device's configuration, for backup (and restore after a reset)
+
+// device timetag seconds: a plain timestamp, or a timestamp on a stomp to hold for the next boundary (see StompboxOSC.cpp)
+const TIMETAG_STAMP = 0;
+const TIMETAG_QUANTISE = 1;
+
+// a held stomp must be complete (some are several messages, ~10 ms apart) before its boundary is released
+const STOMP_GATHER = 30000; // µs
+// the release timer is set this far ahead of the boundary: timers fire late, rarely early (the bundle's timetag is exact)
+const RELEASE_EARLY = 1000; // µs
+
+// Reaper feedback the bridge reads for itself, and doesn't pass on to the device (there's a lot of it)
+const BRIDGE_ONLY = ['/beat/str', '/time', '/time/str'];
+
+// event log types, in firmware order (see StompboxEventLog.h), and how to show each one's argument
+const EVENT_TYPES = [
+	['-', null], ['boot', null], ['press', 'button'], ['release', 'button'],
+	['knob', (arg) => `knob ${arg & 0x7F} ${(arg & 0x80) ? 'down' : 'up'}`],
+	['send', 'messages'], ['receive', (arg) => arg ? 'bundle' : 'message'],
+	['record', 'recording'], ['bypass', 'fx'], ['fxparam', (arg) => `fx ${arg >> 4} param ${arg & 0x0F}`],
+	['ERROR', (arg) => ['', 'bad packet start', 'bad bundle', 'damaged packet'][arg] || arg],
+	['connection', 'connected'], ['hibernate', 'hibernating'],
+];
+
+// loop phases and reset flags, in firmware order (see StompboxResetRecord.h)
+const RESET_PHASES = ['setup', 'scanControls', 'listenForOSC', 'dispatch', 'listenForMIDI', 'send', 'LED show', 'hibernating'];
+const RESET_FLAGS = ['power-on', 'external', 'brown-out', 'watchdog', '', 'JTAG'];
+
+// benchmarks, in firmware order (see handleOSC_Bench)
+const BENCHMARKS = ['LED show', 'analogRead pair', 'scanControls', 'OSC encode+send', 'bundle dispatch'];
+
+// press-to-wire latency histograms: kinds of control, in firmware order, and buckets per kind (see StompboxLatency.h)
+const LATENCY_CLASSES = ['button', 'knob', 'pedal'];
+const LATENCY_BUCKETS = 20;
+
+// device diagnostics: severities and kinds, in firmware order (see StompboxDiagnostics.h)
+const DIAG_SEVERITIES = ['info', 'WARNING', 'ERROR'];
+const DIAG_KINDS = [
+	['bad OSC packet start', (detail) => `byte ${detail}`],
+	['bad OSC bundle', (detail) => `error ${detail}`],
+	['config push rejected', (detail) => CONFIG_RESULTS[detail] || detail],
+	['damaged packet from the bridge', (detail) => `sequence ${detail}`],
+	['packets from the bridge lost', (detail) => `${detail} missing`],
+];
+
+// results of /stompbox/config, in the firmware's config_result_e order
+const CONFIG_RESULTS = ['applied', 'rejected: layout doesn\'t match this firmware', 'rejected: value out of range'];
+
+// when did we last pass a device packet on to Reaper, and has Reaper answered since?
+// (Reaper has no clock we can see, so bridge->Reaper and Reaper->bridge can only be measured together, as its turnaround.)
+let lastForwardTime = 0;
+let awaitingReaper = false;
+
+// stomps held for the next boundary, and when they go (bridge µs)
+let held = [];
+let heldRelease = 0;
+let heldBoundary = 0;
+
+// a saved configuration is on its way to the device (waiting for /stompbox/config/reply)
+let configRestoring = false;
+let configRestoreFailed = false;
+
+// an event log dump coming in, chunk by chunk (see takeEventLogChunk)
+let eventLogDump = null;
+
+function startDeviceServices() {
+	sendLink();
+	sendSync();
+	sendQuantise();
+	setInterval(() => { sendLink(); sendSync(); sendQuantise(); }, syncInterval); // (repeated in case the device restarts)
+	if (verbose >= 2) {
+		setInterval(reportLatency, latencyReportInterval);
+	}
+	if (configStore) {
+		requestConfig();
+		setInterval(requestConfig, configInterval);
+	}
+	listenForCommands();
+}
+
+// a complete packet has arrived from the device
+function receiveDevicePacket(packet) {
+
+	let now = ClockSync.now();
+
+	// once synced, the device wraps each packet in a bundle timetagged with its own clock (seconds 0, fraction = device micros).
+	let bundle = OSC.decodeBundle(packet);
+	let stomp = false;
+	if (bundle && (bundle.seconds == TIMETAG_STAMP || bundle.seconds == TIMETAG_QUANTISE)) {
+		stomp = (bundle.seconds == TIMETAG_QUANTISE);
+		if (clock.synced) {
+			latency.record('device->bridge', now - clock.deviceToBridge(bundle.fraction, now));
+		}
+		// pass it on as it would have been sent without the stamp
+		if (bundle.elements.length == 1) {
+			packet = Buffer.from(bundle.elements[0]);
+		} else {
+			packet = OSC.encodeBundle(OSC.IMMEDIATE.seconds, OSC.IMMEDIATE.fraction, bundle.elements);
+		}
+	}
+
+	let message = OSC.decodeMessage(packet);
+	if (message && message.address.startsWith(DEVICE_PREFIX)) {
+		handleDeviceMessage(message, now);
+		return;
+	}
+
+	if (stomp) {
+		holdStomp(packet, now);
+		return;
+	}
+
+	forwardToReaper(packet, ClockSync.now());
+}
+
+function forwardToReaper(packet, now) {
+	sendUDP(packet);
+	lastForwardTime = now;
+	awaitingReaper = true;
+}
+
+// a message from the device to the bridge itself
+function handleDeviceMessage(message, now) {
+
+	if (verbose >= 3) {
+		console.log(`device: ${message.address} ${message.args.map(arg => arg.value).join(' ')}`);
+	}
+
+	switch (message.address) {
+
+		case '/stompbox/sync/reply': {
+			let [t1, t2, t3] = message.args.map(arg => arg.value);
+			let legs = clock.reply(t1, t2, t3, now);
+			latency.record('bridge->device', legs.bridgeToDevice);
+			if (verbose >= 3) {
+				console.log(`sync: offset ${legs.offset} us, delay ${legs.delay} us, drift ${clock.drift.toFixed(1)} ppm`);
+			}
+			break;
+		}
+
+		case '/stompbox/reset':
+			reportReset(...message.args.map(arg => arg.value));
+			break;
+
+		case '/stompbox/log/reply':
+			takeEventLogChunk(...message.args.map(arg => arg.value));
+			break;
+
+		case '/stompbox/diag':
+			reportDiagnostic(...message.args.map(arg => arg.value));
+			break;
+
+		case '/stompbox/latency/reply':
+			reportDeviceLatency(message.args[0].value);
+			break;
+
+		case '/stompbox/link/stats/reply': {
+			let [received, lost, corrupt, reordered, sent] = message.args.map(arg => arg.value);
+			link.report({ received, lost, corrupt, reordered, sent });
+			break;
+		}
+
+		case '/stompbox/bench/reply':
+			reportCycles('Benchmarks', BENCHMARKS, message.args[0].value, message.args[1].value);
+			break;
+
+		case '/stompbox/config/reply':
+			configRestoring = false;
+			configRestoreFailed = (message.args[0].value != 0);
+			if (verbose >= 1 || configRestoreFailed) {
+				console.log(`config: ${CONFIG_RESULTS[message.args[0].value] || message.args[0].value}`);
+			}
+			break;
+
+		case '/stompbox/config/dump/reply':
+			if (verbose >= 3) {
+				console.log(`config: ${message.args[0].value.toString('hex')}`);
+			}
+			if (configStore) {
+				noteDeviceConfig(message.args[0].value, message.args.length > 1 ? message.args[1].value : 1);
+			}
+			break;
+
+	}
+}
+
+// a packet has arrived from Reaper
+function noteReaperPacket() {
+
+	let now = ClockSync.now();
+	if (awaitingReaper && (now - lastForwardTime < 1000000)) {
+		latency.record('bridge->reaper->bridge', now - lastForwardTime);
+	}
+	awaitingReaper = false;
+}
+
+// a packet from Reaper: note the transport feedback, and return what (if anything) the device should get
+function filterReaperPacket(packet) {
+
+	let bundle = OSC.decodeBundle(packet);
+	if (!bundle) {
+		return noteTransport(OSC.decodeMessage(packet)) ? null : packet;
+	}
+
+	let elements = bundle.elements.filter(element => !noteTransport(OSC.decodeMessage(element)));
+	if (elements.length == bundle.elements.length) {
+		return packet;
+	} else if (elements.length == 0) {
+		return null;
+	}
+	return OSC.encodeBundle(bundle.seconds, bundle.fraction, elements);
+}
+
+// feed Reaper's tempo and play position to the quantiser; true if the device needn't see this message
+function noteTransport(message) {
+
+	if (!message) {
+		return false;
+	}
+	let value = message.args.length ? message.args[0].value : null;
+
+	switch (message.address) {
+		case '/tempo/raw':
+			quantiser.tempo(value);
+			break;
+		case '/play':
+			quantiser.playing(value != 0);
+			break;
+		case '/beat/str':
+			quantiser.beat(value, ClockSync.now());
+			break;
+	}
+	return BRIDGE_ONLY.includes(message.address);
+}
+
+// the Reaper side of a stomp's trip: half the measured turnaround (0 until we have one)
+function reaperLead() {
+	let turnaround = latency.summary()['bridge->reaper->bridge'];
+	return turnaround ? turnaround.p50 / 2 : 0;
+}
+
+// hold a stomp to land on the next beat or bar boundary (or pass it straight on, if the transport isn't running)
+function holdStomp(packet, now) {
+
+	if (held.length > 0) {
+		held.push(packet); // the rest of a stomp already waiting (or another stomp close behind): same boundary
+		return;
+	}
+
+	let lead = reaperLead();
+	let boundary = quantiser.nextBoundary(now, lead + STOMP_GATHER);
+	if (boundary === null) {
+		forwardToReaper(packet, now);
+		return;
+	}
+
+	held.push(packet);
+	heldBoundary = boundary;
+	heldRelease = boundary - lead;
+	setTimeout(releaseStomps, Math.max(0, (heldRelease - RELEASE_EARLY - now) / 1000));
+
+	if (verbose >= 3) {
+		console.log(`quantise: holding ${((heldRelease - now) / 1000).toFixed(1)} ms`);
+	}
+}
+
+// send the held stomps as one bundle, timetagged for the boundary itself
+function releaseStomps() {
+
+	let now = ClockSync.now();
+	let [seconds, fraction] = ntpTime(Date.now() + (heldBoundary - now) / 1000);
+	forwardToReaper(OSC.encodeBundle(seconds, fraction, held), now);
+	held = [];
+}
+
+// OSC (NTP) timetag for a wall-clock time in ms
+function ntpTime(ms) {
+	const NTP_EPOCH_OFFSET = 2208988800; // seconds from 1900 to 1970
+	let seconds = Math.floor(ms / 1000);
+	let fraction = Math.min(0xFFFFFFFF, Math.round((ms - seconds * 1000) / 1000 * 0x100000000));
+	return [seconds + NTP_EPOCH_OFFSET, fraction];
+}
+
+function requestConfig() {
+	if (configRestoring) {
+		configRestoring = false; // (no answer in a whole interval: ask again next time)
+		return;
+	}
+	sendSerial(OSC.encodeMessage('/stompbox/config/dump'));
+}
+
+// the device's configuration, and whether it has changed since the device booted:
+// if it has, back it up; if not (a reset or reflash put it back to the defaults), restore our backup
+function noteDeviceConfig(config, changed) {
+
+	if (!configStore.differs(config)) {
+		return;
+	}
+
+	if (!changed && configStore.config) {
+		if (configRestoring || configRestoreFailed) {
+			return;
+		}
+		if (!configStore.fits(config)) {
+			console.warn('*** Saved config is for different firmware; not restoring it (turn a meta knob to start a new backup)');
+			configRestoreFailed = true;
+			return;
+		}
+		if (verbose >= 1) {
+			console.log('- Restoring saved config to Stompbox');
+		}
+		configRestoring = true;
+		sendSerial(OSC.encodeMessage('/stompbox/config', [{ type: 'b', value: configStore.config }]));
+		return;
+	}
+
+	configStore.save(config);
+	configRestoreFailed = false;
+	if (verbose >= 1) {
+		console.log('- Saved Stompbox config to ' + configStore.path);
+	}
+}
+
+// typed commands (then Enter): 'log' shows the device's event log, 'bench' runs its benchmarks,
+// 'latency' shows latency so far (including the device's press-to-wire histograms), 'link' shows link quality
+function listenForCommands() {
+	process.stdin.setEncoding('utf8');
+	process.stdin.on('data', (text) => {
+		for (let line of text.split('\n')) {
+			if (line.trim() == 'log') {
+				sendSerial(OSC.encodeMessage('/stompbox/log'));
+			} else if (line.trim() == 'bench') {
+				sendSerial(OSC.encodeMessage('/stompbox/bench'));
+			} else if (line.trim() == 'latency') {
+				reportLatency();
+			} else if (line.trim() == 'link') {
+				sendSerial(OSC.encodeMessage('/stompbox/link/stats'));
+			}
+		}
+	});
+}
+
+function sendQuantise() {
+	sendSerial(OSC.encodeMessage('/stompbox/quantise', [{ type: 'i', value: quantiser.enabled ? 1 : 0 }]));
+}
+
+function sendLink() {
+	sendSerial(OSC.encodeMessage('/stompbox/link', [{ type: 'i', value: linkLayer ? 1 : 0 }]));
+}
+
+function sendSync() {
+	sendSerial(OSC.encodeMessage('/stompbox/sync', [{ type: 'i', value: clock.request() }]));
+}
+
+// something the device noticed, counted up since its last report of the kind
+function reportDiagnostic(severity, kind, count, overMs, detail) {
+	if (severity == 0 && verbose < 2) {
+		return;
+	}
+	let [name, describe] = DIAG_KINDS[kind] || [`kind ${kind}`, (detail) => detail];
+	let times = (count == 1) ? '' : ` x${count} in ${(overMs / 1000).toFixed(1)} s`;
+	console.log(`- Stompbox ${DIAG_SEVERITIES[severity] || severity}: ${name}${times} (latest: ${describe(detail)})`);
+}
+
+// how the device's last run ended (sent once per boot, when it first hears from us)
+function reportReset(flags, warm, phase, minFreeRam, inputBacklog, loops, uptime, lastAddress) {
+	let causes = RESET_FLAGS.filter((name, bit) => name && (flags & (1 << bit)));
+	let cause = causes.length ? causes.join(', ') : 'not reported';
+	if (!warm) {
+		if (verbose >= 1) {
+			console.log(`- Stompbox powered up (reset flags: ${cause})`);
+		}
+		return;
+	}
+	// a warm reset: expected after an upload or the reset button, otherwise worth knowing about
+	console.log(`- Stompbox was reset (reset flags: ${cause}) after ${(uptime / 1000).toFixed(1)} s, ${loops} loops,`
+		+ ` in phase ${RESET_PHASES[phase] || phase}; last address ${lastAddress || '(none)'},`
+		+ ` lowest free RAM ${minFreeRam} bytes, most serial input waiting ${inputBacklog} bytes`);
+}
+
+// the device sends its event log in chunks: put them together, and report it once it's all here
+// (a chunk at offset 0 starts afresh, so a dump with a chunk lost on the way is just never reported)
+function takeEventLogChunk(deviceNow, next, offset, size, chunk) {
+	if (offset == 0)
+		eventLogDump = { deviceNow, next, blob: Buffer.alloc(size), received: 0 };
+	let dump = eventLogDump;
+	if (!dump || dump.deviceNow != deviceNow || dump.blob.length != size || offset + chunk.length > size)
+		return; // (the start of this dump went missing)
+	chunk.copy(dump.blob, offset);
+	dump.received += chunk.length;
+	if (dump.received == size) {
+		eventLogDump = null;
+		reportEventLog(dump.deviceNow, dump.next, dump.blob);
+	}
+}
+
+// the device's event log, oldest first, timed back from when it replied
+function reportEventLog(deviceNow, next, blob) {
+	const EVENT_SIZE = 6;
+	let count = blob.length / EVENT_SIZE;
+	let previous = null;
+	console.log('- Event log (ms before the dump, then since the event before):');
+	for (let ii = 0; ii < count; ii++) {
+		let offset = ((next + ii) % count) * EVENT_SIZE;
+		let time = blob.readUInt32LE(offset);
+		let [name, describe] = EVENT_TYPES[blob[offset + 4]] || [`type ${blob[offset + 4]}`, null];
+		let arg = blob[offset + 5];
+		if (blob[offset + 4] == 0) {
+			continue; // empty slot
+		}
+		let age = ((deviceNow - time) >>> 0) / 1000;
+		let since = (previous == null) ? '' : `+${(((time - previous) >>> 0) / 1000).toFixed(3)}`;
+		let detail = (typeof describe == 'function') ? describe(arg) : describe ? `${describe} ${arg}` : '';
+		console.log(`  ${('-' + age.toFixed(3)).padStart(11)} ${since.padStart(10)}  ${name.padEnd(10)} ${detail}`);
+		previous = time;
+	}
+}
+
+// print (count, total, max) cycles per slot from a benchmark reply: count and mean/max since the last report
+function reportCycles(title, names, clockHz, blob) {
+	console.log(`- ${title} (${clockHz / 1e6} MHz):`);
+	for (let ii = 0; ii * 12 + 12 <= blob.length; ii++) {
+		let count = blob.readUInt32BE(ii * 12);
+		let total = blob.readUInt32BE(ii * 12 + 4);
+		let max = blob.readUInt32BE(ii * 12 + 8);
+		let mean = count ? Math.round(total / count) : 0;
+		let us = (cycles) => (cycles * 1e6 / clockHz).toFixed(1);
+		console.log(`  ${(names[ii] || `slot ${ii}`).padEnd(16)} n=${String(count).padStart(6)}  mean ${String(mean).padStart(8)} cycles (${us(mean)} us)  max ${String(max).padStart(8)} cycles (${us(max)} us)`);
+	}
+}
+
+function reportLatency() {
+	console.log(`- Latency (clock drift ${clock.drift.toFixed(1)} ppm):`);
+	latency.report();
+	sendSerial(OSC.encodeMessage('/stompbox/latency'));
+	sendSerial(OSC.encodeMessage('/stompbox/link/stats'));
+}
+
+// the device's own press-to-wire histograms (log2 buckets: percentiles are the top of the bucket they fall in, so within 2x)
+function reportDeviceLatency(blob) {
+	const CLASS_SIZE = 8 + LATENCY_BUCKETS * 2;
+	let ms = (us) => (us / 1000).toFixed(2);
+	for (let ii = 0; ii * CLASS_SIZE + CLASS_SIZE <= blob.length; ii++) {
+		let offset = ii * CLASS_SIZE;
+		let count = blob.readUInt32BE(offset);
+		let max = blob.readUInt32BE(offset + 4);
+		let buckets = [];
+		for (let jj = 0; jj < LATENCY_BUCKETS; jj++) {
+			buckets.push(blob.readUInt16BE(offset + 8 + jj * 2));
+		}
+		if (count == 0) {
+			continue;
+		}
+		let at = (p) => {
+			let total = buckets.reduce((sum, n) => sum + n, 0);
+			let seen = 0;
+			for (let jj = 0; jj < LATENCY_BUCKETS; jj++) {
+				seen += buckets[jj];
+				if (seen >= p * total) {
+					return Math.min(2 ** (jj + 1), max);
+				}
+			}
+			return max;
+		};
+		let label = `press->wire: ${LATENCY_CLASSES[ii] || ii}`;
+		console.log(`  ${label.padEnd(24)} n=${String(count).padStart(4)}  p50 <${ms(at(0.50))}  p99 <${ms(at(0.99))}  max ${ms(max)} ms`);
+	}
+}
+
+//#endregion
@@ -0,0 +1,51 @@
+// OSC decoding of damaged packets: whatever arrives, the decoders answer null rather than throwing.
+//
+//   node --test        (in Stompbox PC Bridge)
+
+const test = require('node:test');
+const assert = require('node:assert');
+const OSC = require('../OSC.js');
+
+const message = OSC.encodeMessage('/stompbox/test', [
+    { type: 'i', value: -7 },
+    { type: 'f', value: 0.5 },
+    { type: 's', value: 'hello' },
+    { type: 'b', value: Buffer.from([1, 2, 3, 4, 5]) }
+]);
+
+test('an intact message decodes', () => {
+    let decoded = OSC.decodeMessage(message);
+    assert.strictEqual(decoded.address, '/stompbox/test');
+    assert.deepStrictEqual(decoded.args.map(arg => arg.value), [-7, 0.5, 'hello', Buffer.from([1, 2, 3, 4, 5])]);
+});
+
+test('a message cut short anywhere decodes to null, without throwing', () => {
+    // (cut in the address or tags, the message may still read as one with fewer arguments; never as a full one.
+    // The blob's last 3 bytes are padding: without them, it's all still there.)
+    for (let length = 0; length < message.length - 3; length++) {
+        let decoded = OSC.decodeMessage(message.subarray(0, length));
+        assert.ok(decoded == null || decoded.args.length < 4, `cut to ${length} bytes`);
+    }
+});
+
+test('each fixed-size argument cut short is caught', () => {
+    for (let type of ['i', 'f']) {
+        let packet = OSC.encodeMessage('/x', [{ type, value: 1 }]);
+        assert.strictEqual(OSC.decodeMessage(packet.subarray(0, packet.length - 2)), null, type);
+    }
+});
+
+test('a blob longer than the packet is caught', () => {
+    let packet = Buffer.from(OSC.encodeMessage('/x', [{ type: 'b', value: Buffer.alloc(8) }]));
+    packet.writeUInt32BE(100, packet.length - 12);
+    assert.strictEqual(OSC.decodeMessage(packet), null);
+});
+
+test('a bundle cut short decodes to null, without throwing', () => {
+    let bundle = OSC.encodeBundle(1, 2, [message, message]);
+    assert.strictEqual(OSC.decodeBundle(bundle).elements.length, 2);
+    for (let length = 0; length < bundle.length; length++) {
+        let decoded = OSC.decodeBundle(bundle.subarray(0, length));
+        assert.ok(decoded == null || decoded.elements.length < 2, `cut to ${length} bytes`);
+    }
+});
@@ -0,0 +1,469 @@
+// Stompbox simulator: runs the firmware image under simavr, drives its pins from a stimulus script, gives its serial
+// link a virtual port, and reports exact cycle counts for each profiled section (see StompboxProfile.h).
+//
+//   stompbox-sim [-t seconds] [-l section-log.csv] [-p pty-link] firmware.elf [stimulus.stim]
+//
+// The firmware must be built with STOMPBOX_PROFILE (the section markers) and STOMPBOX_SERIAL_UART (SLIP on the UART,
+// since there's no USB here); the Makefile does both. Its serial link appears as a pseudo-terminal, linked from
+// /tmp/stompbox-sim (or -p): point the bridge at it, or leave it be and the firmware just talks to no one.
+//
+// Every section is timed from the cycle its start marker is written to the cycle its end marker is, so nothing but the
+// markers themselves (one OUT instruction each) is added to what's measured, and the same image and stimulus give the
+// same counts every run (unless something is talking to the serial port). Sections report their time with and without
+// the rotary interrupts that landed in them (other interrupts, such as the millis() timer's, aren't marked).
+//
+// Stimulus script: one command per line, in time order; '#' starts a comment. Times are ms of simulated time.
+//   at <ms> high <pin>...              drive pins high (released buttons, idle encoder lines: do this first, at 0)
+//   at <ms> low <pin>...               drive pins low
+//   at <ms> press <pin>                a button goes down (low)...
+//   at <ms> release <pin>              ...and up (high)
+//   at <ms> turn <pin A> <pin B> <n>   turn an encoder n detents (+ up, - down), one every 3 ms
+//   at <ms> adc <pin> <volts>          set an analog input (A0-A5)
+//   at <ms> end                        stop here and report
+// Pins are Arduino (ItsyBitsy 32u4) numbers, or A0-A5: see StompboxHardware.h for which is which.
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_irq.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <simavr/avr_adc.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pty.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define CPU_HZ 16000000UL
+#define CYCLES_PER_MS (CPU_HZ / 1000)
+
+// the profile markers' registers, as data addresses (StompboxProfile.h: GPIOR1 and GPIOR2, I/O 0x2A and 0x2B)
+#define PROFILE_BEGIN_ADDR 0x4A
+#define PROFILE_END_ADDR 0x4B
+
+// the USB PLL's control register (I/O 0x29): the Arduino core waits for it to lock at startup
+#define PLLCSR_ADDR 0x49
+#define PLLCSR_PLLE 0x02
+#define PLLCSR_PLOCK 0x01
+
+// profile slots, in firmware order (see StompboxProfile.h)
+static const char *PROFILE_SLOTS[] = { "loop", "scanControls", "listenForOSC", "OSC packet send", "LED show", "rotary ISR" };
+#define NUM_PROFILE_SLOTS (sizeof(PROFILE_SLOTS) / sizeof(PROFILE_SLOTS[0]))
+#define PROFILE_ROTARY_ISR 5
+
+// ---------- pins ---------- //
+
+// Arduino pin number -> port and bit (ItsyBitsy 32u4 / Leonardo numbering; the same table as hwPinLow)
+typedef struct pin_s {
+  char port;
+  int bit;
+} pin_s;
+
+static const pin_s PINS[] = {
+  { 'D', 2 }, { 'D', 3 }, { 'D', 1 }, { 'D', 0 }, { 'D', 4 }, { 'C', 6 }, { 'D', 7 }, { 'E', 6 },   // 0-7
+  { 'B', 4 }, { 'B', 5 }, { 'B', 6 }, { 'B', 7 }, { 'D', 6 }, { 'C', 7 }, { 'B', 3 }, { 'B', 1 },   // 8-15
+  { 'B', 2 }, { 'B', 0 }, { 'F', 7 }, { 'F', 6 }, { 'F', 5 }, { 'F', 4 }, { 'F', 1 }, { 'F', 0 }    // 16-17, A0-A5
+};
+#define NUM_PINS (int)(sizeof(PINS) / sizeof(PINS[0]))
+#define FIRST_ANALOG_PIN 18
+
+/// "10" or "A3" -> Arduino pin number (-1 if it isn't one)
+static int parsePin(const char *text) {
+
+  char *end;
+  long pin;
+  if ((text[0] == 'A') || (text[0] == 'a')) {
+    pin = FIRST_ANALOG_PIN + strtol(text + 1, &end, 10);
+  } else {
+    pin = strtol(text, &end, 10);
+  }
+  return ((*end == 0) && (end != text) && (pin >= 0) && (pin < NUM_PINS)) ? (int)pin : -1;
+
+}
+
+// ---------- stimulus ---------- //
+
+typedef enum stimulus_e { STIMULUS_PIN, STIMULUS_ADC, STIMULUS_END } stimulus_e;
+
+typedef struct stimulus_s {
+  avr_cycle_count_t cycle;
+  stimulus_e kind;
+  int pin;
+  uint32_t value;           // pin level, or millivolts
+} stimulus_s;
+
+static stimulus_s *stimulus = NULL;
+static int num_stimulus = 0;
+static int pin_level[NUM_PINS];    // as the script has left them, for working out encoder turns
+
+static void addStimulus(avr_cycle_count_t cycle, stimulus_e kind, int pin, uint32_t value) {
+
+  // keep them in time order (a turn's detents can run past the next line's time)
+  stimulus = realloc(stimulus, (num_stimulus + 1) * sizeof(stimulus_s));
+  int ii = num_stimulus++;
+  while ((ii > 0) && (stimulus[ii - 1].cycle > cycle)) {
+    stimulus[ii] = stimulus[ii - 1];
+    ii--;
+  }
+  stimulus[ii] = (stimulus_s) { cycle, kind, pin, value };
+  if (kind == STIMULUS_PIN) {
+    pin_level[pin] = value;
+  }
+
+}
+
+/// read a stimulus script: false (with a message) if it doesn't make sense
+static int readStimulus(const char *path) {
+
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  char line[256];
+  int line_number = 0;
+  while (fgets(line, sizeof(line), file)) {
+    line_number++;
+    char *comment = strchr(line, '#');
+    if (comment) {
+      *comment = 0;
+    }
+
+    char *words[16];
+    int count = 0;
+    for (char *word = strtok(line, " \t\r\n"); word && (count < 16); word = strtok(NULL, " \t\r\n")) {
+      words[count++] = word;
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    int ok = (count >= 3) && (strcmp(words[0], "at") == 0);
+    avr_cycle_count_t cycle = ok ? (avr_cycle_count_t)(atof(words[1]) * CYCLES_PER_MS) : 0;
+    const char *command = ok ? words[2] : "";
+
+    if (ok && (!strcmp(command, "high") || !strcmp(command, "low") || !strcmp(command, "press")
+        || !strcmp(command, "release"))) {
+      int level = !strcmp(command, "high") || !strcmp(command, "release");
+      for (int ii = 3; ok && (ii < count); ii++) {
+        int pin = parsePin(words[ii]);
+        ok = (pin >= 0);
+        if (ok) {
+          addStimulus(cycle, STIMULUS_PIN, pin, level);
+        }
+      }
+      ok = ok && (count >= 4);
+    } else if (ok && !strcmp(command, "turn") && (count == 6)) {
+      // a detent: B to where A is about to go (up) or where it is (down), then A flips; the ISR compares them
+      // (detents 3 ms apart: its debounce ignores edges within 1 ms)
+      int pin_a = parsePin(words[3]), pin_b = parsePin(words[4]);
+      int detents = atoi(words[5]);
+      ok = (pin_a >= 0) && (pin_b >= 0);
+      for (int ii = 0; ok && (ii < abs(detents)); ii++) {
+        avr_cycle_count_t at = cycle + ii * 3 * CYCLES_PER_MS;
+        int a = pin_level[pin_a];
+        addStimulus(at, STIMULUS_PIN, pin_b, (detents > 0) ? !a : a);
+        addStimulus(at + CYCLES_PER_MS / 10, STIMULUS_PIN, pin_a, !a);
+      }
+    } else if (ok && !strcmp(command, "adc") && (count == 5)) {
+      int pin = parsePin(words[3]);
+      ok = (pin >= FIRST_ANALOG_PIN);
+      if (ok) {
+        addStimulus(cycle, STIMULUS_ADC, pin, (uint32_t)(atof(words[4]) * 1000));
+      }
+    } else if (ok && !strcmp(command, "end") && (count == 3)) {
+      addStimulus(cycle, STIMULUS_END, 0, 0);
+    } else {
+      ok = 0;
+    }
+
+    if (!ok) {
+      fprintf(stderr, "%s:%d: can't make sense of this\n", path, line_number);
+      fclose(file);
+      return 0;
+    }
+  }
+
+  fclose(file);
+  return 1;
+
+}
+
+/// apply one stimulus to the chip
+static void applyStimulus(avr_t *avr, const stimulus_s *event) {
+
+  const pin_s *pin = &PINS[event->pin];
+  switch (event->kind) {
+    case STIMULUS_PIN:
+      avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(pin->port), pin->bit), event->value);
+      break;
+    case STIMULUS_ADC:
+      // (A0-A5 are all on port F, at the bit numbered as their ADC channel)
+      avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + pin->bit), event->value);
+      break;
+    case STIMULUS_END:
+      break;
+  }
+
+}
+
+// ---------- profile ---------- //
+
+typedef struct slot_stats_s {
+  uint64_t count;
+  uint64_t total;           // cycles, including any rotary interrupts that landed in it
+  uint64_t total_isr;       // of which in rotary interrupts
+  uint64_t min;
+  uint64_t max;
+  avr_cycle_count_t start;
+  uint64_t isr_at_start;
+  int open;
+} slot_stats_s;
+
+static slot_stats_s slot_stats[NUM_PROFILE_SLOTS];
+static uint64_t isr_cycles = 0;     // all the rotary interrupts' cycles so far
+static FILE *section_log = NULL;
+
+static void profileBegin(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+
+  avr->data[addr] = v;
+  if (v < NUM_PROFILE_SLOTS) {
+    slot_stats[v].start = avr->cycle;
+    slot_stats[v].isr_at_start = isr_cycles;
+    slot_stats[v].open = 1;
+  }
+
+}
+
+static void profileEnd(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+
+  avr->data[addr] = v;
+  if ((v >= NUM_PROFILE_SLOTS) || !slot_stats[v].open) {
+    return;
+  }
+  slot_stats_s *slot = &slot_stats[v];
+  uint64_t cycles = avr->cycle - slot->start;
+  uint64_t isr = isr_cycles - slot->isr_at_start;
+  slot->open = 0;
+  slot->count++;
+  slot->total += cycles;
+  slot->total_isr += isr;
+  if ((slot->count == 1) || (cycles < slot->min)) {
+    slot->min = cycles;
+  }
+  if (cycles > slot->max) {
+    slot->max = cycles;
+  }
+  if (v == PROFILE_ROTARY_ISR) {
+    isr_cycles += cycles;
+  }
+  if (section_log) {
+    fprintf(section_log, "%s,%llu,%llu,%llu\n", PROFILE_SLOTS[v], (unsigned long long)slot->start,
+      (unsigned long long)cycles, (unsigned long long)isr);
+  }
+
+}
+
+static void report(avr_t *avr) {
+
+  double us_per_cycle = 1e6 / CPU_HZ;
+  printf("- Profile: %.3f s simulated (%llu cycles at %lu MHz)\n", avr->cycle / (double)CPU_HZ,
+    (unsigned long long)avr->cycle, CPU_HZ / 1000000);
+  printf("  %-16s %8s %10s %10s %10s %12s\n", "section", "n", "min", "mean", "max", "mean w/o ISR");
+  for (size_t ii = 0; ii < NUM_PROFILE_SLOTS; ii++) {
+    slot_stats_s *slot = &slot_stats[ii];
+    if (slot->count == 0) {
+      printf("  %-16s %8d\n", PROFILE_SLOTS[ii], 0);
+      continue;
+    }
+    double mean = slot->total / (double)slot->count;
+    double mean_exclusive = (slot->total - slot->total_isr) / (double)slot->count;
+    printf("  %-16s %8llu %10llu %10.1f %10llu %12.1f   cycles\n", PROFILE_SLOTS[ii], (unsigned long long)slot->count,
+      (unsigned long long)slot->min, mean, (unsigned long long)slot->max, mean_exclusive);
+    printf("  %-16s %8s %10.2f %10.2f %10.2f %12.2f   us\n", "", "", slot->min * us_per_cycle, mean * us_per_cycle,
+      slot->max * us_per_cycle, mean_exclusive * us_per_cycle);
+  }
+
+}
+
+// ---------- virtual serial port ---------- //
+
+static int pty_master = -1;
+static int uart_ready = 1;          // the UART's input has room (it says XOFF when it hasn't)
+static avr_irq_t *uart_input;
+static uint64_t serial_out = 0, serial_in = 0;
+
+static void uartOutput(struct avr_irq_t *irq, uint32_t value, void *param) {
+
+  uint8_t data = value;
+  serial_out++;
+  if (write(pty_master, &data, 1) < 0) {
+    // no one's reading: the byte is dropped, as a disconnected USB port would
+  }
+
+}
+
+static void uartXon(struct avr_irq_t *irq, uint32_t value, void *param) {
+  uart_ready = 1;
+}
+
+static void uartXoff(struct avr_irq_t *irq, uint32_t value, void *param) {
+  uart_ready = 0;
+}
+
+/// open the pseudo-terminal, link it from link_path, and connect UART1 to it
+static int openSerial(avr_t *avr, const char *link_path) {
+
+  int slave;
+  char name[256];
+  if (openpty(&pty_master, &slave, name, NULL, NULL) < 0) {
+    perror("openpty");
+    return 0;
+  }
+  // raw bytes both ways; the slave stays open here, so the master doesn't see a hangup between clients
+  struct termios settings;
+  tcgetattr(slave, &settings);
+  cfmakeraw(&settings);
+  tcsetattr(slave, TCSANOW, &settings);
+  fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) | O_NONBLOCK);
+
+  unlink(link_path);
+  if (symlink(name, link_path) < 0) {
+    perror(link_path);
+  }
+  printf("- Serial link (UART1): %s -> %s\n", link_path, name);
+
+  // no echoing the UART to stdout: it's the SLIP stream
+  uint32_t flags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('1'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('1'), &flags);
+
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('1'), UART_IRQ_OUTPUT), uartOutput, NULL);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('1'), UART_IRQ_OUT_XON), uartXon, NULL);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('1'), UART_IRQ_OUT_XOFF), uartXoff, NULL);
+  uart_input = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('1'), UART_IRQ_INPUT);
+  return 1;
+
+}
+
+/// pass on whatever the port's client has sent, while the UART has room
+static void pollSerial() {
+
+  uint8_t data;
+  while (uart_ready && (read(pty_master, &data, 1) == 1)) {
+    serial_in++;
+    avr_raise_irq(uart_input, data);
+  }
+
+}
+
+// ---------- main ---------- //
+
+/// the USB PLL locks as soon as it's enabled (the Arduino core waits for it; nothing else here uses USB)
+static void pllControl(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  avr->data[addr] = (v & PLLCSR_PLLE) ? (v | PLLCSR_PLOCK) : (v & ~PLLCSR_PLOCK);
+}
+
+static void usage() {
+  fprintf(stderr, "usage: stompbox-sim [-t seconds] [-l section-log.csv] [-p pty-link] firmware.elf [stimulus.stim]\n");
+  exit(2);
+}
+
+int main(int argc, char *argv[]) {
+
+  double seconds = 10.0;
+  const char *link_path = "/tmp/stompbox-sim";
+  int option;
+  while ((option = getopt(argc, argv, "t:l:p:")) != -1) {
+    switch (option) {
+      case 't':
+        seconds = atof(optarg);
+        break;
+      case 'l':
+        section_log = fopen(optarg, "w");
+        if (!section_log) {
+          perror(optarg);
+          return 1;
+        }
+        fprintf(section_log, "section,start_cycle,cycles,rotary_isr_cycles\n");
+        break;
+      case 'p':
+        link_path = optarg;
+        break;
+      default:
+        usage();
+    }
+  }
+  if ((optind >= argc) || (argc - optind > 2)) {
+    usage();
+  }
+
+  for (int ii = 0; ii < NUM_PINS; ii++) {
+    pin_level[ii] = 1;
+  }
+  if ((argc - optind == 2) && !readStimulus(argv[optind + 1])) {
+    return 1;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(argv[optind], &firmware) != 0) {
+    fprintf(stderr, "%s: can't read it\n", argv[optind]);
+    return 1;
+  }
+
+  avr_t *avr = avr_make_mcu_by_name("atmega32u4");
+  if (!avr) {
+    fprintf(stderr, "this simavr doesn't know the atmega32u4\n");
+    return 1;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+  avr->frequency = CPU_HZ;
+  avr->vcc = avr->avcc = avr->aref = 5000; // millivolts
+
+  avr_register_io_write(avr, PROFILE_BEGIN_ADDR, profileBegin, NULL);
+  avr_register_io_write(avr, PROFILE_END_ADDR, profileEnd, NULL);
+  avr_register_io_write(avr, PLLCSR_ADDR, pllControl, NULL);
+  if (!openSerial(avr, link_path)) {
+    return 1;
+  }
+
+  avr_cycle_count_t stop = (avr_cycle_count_t)(seconds * CPU_HZ);
+  int next = 0;
+  int state = cpu_Running;
+  unsigned steps = 0;
+  while ((state != cpu_Done) && (state != cpu_Crashed) && (avr->cycle < stop)) {
+    while ((next < num_stimulus) && (stimulus[next].cycle <= avr->cycle)) {
+      if (stimulus[next].kind == STIMULUS_END) {
+        stop = avr->cycle;
+      }
+      applyStimulus(avr, &stimulus[next++]);
+    }
+    if ((++steps & 1023) == 0) {
+      pollSerial();
+    }
+    state = avr_run(avr);
+  }
+
+  if (state == cpu_Crashed) {
+    printf("- The firmware crashed at %.3f s (pc 0x%04x)\n", avr->cycle / (double)CPU_HZ, avr->pc);
+  }
+  printf("- Serial: %llu bytes out, %llu in\n", (unsigned long long)serial_out, (unsigned long long)serial_in);
+  report(avr);
+
+  if (section_log) {
+    fclose(section_log);
+  }
+  unlink(link_path);
+  return (state == cpu_Crashed) ? 1 : 0;
+
+}
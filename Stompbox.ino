@@ -19,7 +19,7 @@ Other implementation notes:
 -----
 
 Arduino Device: Adafruit ItsyBitsy 32u4
-Pinout:
+Pinout (the original board; other layouts are profiles in StompboxHardware.h):
 0 N/C (reserved for USB serial)
 1 N/C (reserved for USB serial)
 2 Rotary 3 A
@@ -50,8 +50,26 @@ RST (Reset button is connected to reset pin.)
 // ** include ** 
 
 // this code is subdivided somewhat, for convenience
+#include "StompboxConfig.h"
+#include "StompboxHardware.h"
+#include "StompboxKnobs.h"
 #include "StompboxOSC.h"
+#include "StompboxMIDI.h"
+#include "StompboxOutput.h"
 #include "StompboxLEDs.h"
+#include "StompboxProfile.h"
+#include "StompboxTapTempo.h"
+#include "StompboxJoystick.h"
+#include "StompboxCurves.h"
+#include "StompboxMorph.h"
+#include "StompboxOneEuro.h"
+#include "StompboxBlob.h"
+#include "StompboxEventLog.h"
+#include "StompboxResetRecord.h"
+#include "StompboxBench.h"
+#include "StompboxLatency.h"
+#include "StompboxDiagnostics.h"
+#include "StompboxLink.h"
 
 
 // ** types **
@@ -70,17 +88,10 @@ typedef enum button_state_e { UNPRESSED, PRESSING, PRESSED, RELEASING} button_st
 typedef struct pedal_state_s {
   int value;
   int delta;
+  time_us read_time; // micros() of the latest reading
 } pedal_state_s;
 
-// knob states
-typedef struct knob_state_s {
-  int value;
-  int delta;
-  int codeA;
-  int codeB;
-  int direction;
-  bool changed;
-} knob_state_s;
+// knob states: see StompboxKnobs.h
 
 // note: Reaper DAW sends both 'record ON' and 'play ON' simultaneously; 
 // but OSC dispatch paradigm does not make it easy to respond appropriately and track both.
@@ -96,11 +107,38 @@ typedef struct daw_fx_knob_s {
 
 } daw_fx_knob_s;
 
-typedef struct knob_configuration_s {
+/// a knob can either send absolute values (our running guess at the fx parameter's value),
+// or send just the detents turned, for the DAW to apply to the parameter's true value.
+typedef enum knob_mode_e {
+
+  ABSOLUTE_KNOB,                // sends fxparam values, tracked in daw_state.fx_knob
+  RELATIVE_KNOB,                // sends detent deltas to its relative_control
+
+} knob_mode_e;
+
+/// one of the fx parameters an (absolute) knob drives: the knob's position goes through the curve,
+// is flipped if inverted, then spans minimum to maximum.
+typedef struct knob_target_s {
 
   int fx;
   int fxparam;
+  float minimum;
+  float maximum;
+  bool inverted;
+  response_curve_e curve;
+
+} knob_target_s;
+
+// targets per knob (a few: each is another message in every detent's bundle)
+const int MAX_KNOB_TARGETS = 3;
+
+typedef struct knob_configuration_s {
+
+  knob_target_s target[MAX_KNOB_TARGETS]; // ABSOLUTE_KNOB: all move together, one update per detent. target[0] is the one the meta knobs reassign.
+  int num_targets;
   float step_size;
+  knob_mode_e knob_mode;
+  int relative_control; // RELATIVE_KNOB target: a Reaper action ID (OSC) or CC number (MIDI); see Output::relativeControl
 
 } knob_configuration_s;
 
@@ -109,22 +147,43 @@ typedef struct knob_configuration_s {
 typedef struct daw_state_s {
 
   bool recording; // our recording studio red light
-  bool fx_bypass[9]; // we control bypass on fx 2-8. Array elements 0 and 1 are ignored.
+  bool fx_bypass[9]; // we control bypass on fx 2-8 (LAST_FX_INDEX). Array elements 0 and 1 are ignored: see fxBypassed.
   //int amp_channel; // modes for plugin "The Anvil (Ignite Amps)" (param 2): saved here as 0, 1, 2 -- but over OSC, normalize to 0.0, 0.5, 1.0
-  float fx_value[9]; // the fx parameters controlled by the buttons (only relevant for buttons 1-8, and only for buttons not in BYPASS mode)
-  daw_fx_knob_s fx_knob[3]; // the fx parameters controlled by the knobs
+  float fx_value[NUM_BUTTONS]; // the fx parameters controlled by the buttons (only relevant for stomp and knob select buttons, and only for buttons not in BYPASS mode)
+  daw_fx_knob_s fx_knob[NUM_KNOBS]; // the fx parameters controlled by the knobs
+  float tempo; // the tempo we last asked for by tap (0.0 = none yet)
 
 } daw_state_s;
 
+/// what a joystick control axis controls
+typedef struct joystick_configuration_s {
+
+  int fx;
+  int fxparam;
+  response_curve_e curve;
+
+} joystick_configuration_s;
+
+/// what the external expression pedal does
+typedef enum pedal_mode_e {
+
+  IGNORED_PEDAL,                // does nothing
+  FXPARAM_PEDAL,                // sends one fx parameter (the wah)
+  MORPH_PEDAL,                  // sends several fx parameters at once, morphing between two scenes (see StompboxMorph.h)
+
+} pedal_mode_e;
+
 /// a button can behave in one of several useful ways, currently:
 // as an fx bypass button (like a typical guitar pedal main stomp);
 // to cycle between fx parameter values;
+// to tap the tempo;
 // or doing nothing at all.
 typedef enum button_mode_e { 
 
   IGNORED_BUTTON,               // does nothing
   FX_BYPASS,                    // sends bypass on/off messages
   FXPARAM_CYCLE_3,              // sends fxparam value cycle among 0, 0.5, 1
+  TAP_TEMPO,                    // sends the tempo of the taps, once it's steady
 //  FXPARAM_CYCLE_10              // sends fxparam value cycle among .0, .1, .2, ..., .9, 1.0, .0, .1, ...
 
 } button_mode_e;
@@ -139,22 +198,19 @@ typedef struct button_configuration_s {
 
 } button_configuration_s;
 
-// ** constants **
-
-// Record button plus five footswitch stomp buttons
-const int NUM_BASIC_BUTTONS = 6;
+/// outcome of a configuration push (see handleOSC_Config), as reported back to the PC
+typedef enum config_result_e {
 
-// Knob and joystick push-select action: also counts as "buttons" for control scan
-const int NUM_SELECT_BUTTONS = 4;
+  CONFIG_OK,
+  CONFIG_BAD_LAYOUT,            // wrong version, size or counts: nothing applied
+  CONFIG_BAD_VALUE,             // some value out of range: nothing applied
 
-// total buttons of both kinds
-const int NUM_BUTTONS = NUM_BASIC_BUTTONS + NUM_SELECT_BUTTONS;
+} config_result_e;
 
-// Three rotary encoder knobs
-const int NUM_KNOBS = 3;
+// ** constants **
 
-// Two joystick axes and one external expression pedal input
-const int NUM_PEDALS = 3;
+// the buttons, knobs and pedals, their pins and what each button is for: see StompboxHardware.h
+// (NUM_BUTTONS, NUM_KNOBS, NUM_PEDALS, the PEDAL_X/Y/Z indices and the stomp button range all come from there)
 
 // to work around a reaper/OSC glitch, we only control FX #3 and up.
 // (control #2's feedback comes in a bundle with a bad size apparently?)
@@ -162,53 +218,10 @@ const int FIRST_FX_INDEX = 3;
 const int LAST_FX_INDEX = 8; // apparent S&M_FXBYP limit
                     // (see C:\Users\Dan\AppData\Roaming\REAPER\S&M.ini)
 
-// arduino pin assignments...
-
-//const byte PIN_LED_BUILTIN = LED_BUILTIN; // arduino on-board LED. May or may not be visible in final version of hardware; doubled by amber warning light in record button (separate from record button RGB LED).
-//const byte PIN_LED_DATA = 14; // NeoPixel data out. Controlled via FastLED library.
-const byte PIN_BUTTON_0 = A3; // 'Record' button. LED 0 illuminates the clear button itself (other buttons' LEDs are just adjacent display lamps)
-const byte PIN_BUTTON_1 = 10; // footswitch button 1. (Nominally, a stomp button as found on guitar pedals. I don't like those so I'm using softer-press buttons.)
-const byte PIN_BUTTON_2 = 12;
-const byte PIN_BUTTON_3 = 5;
-const byte PIN_BUTTON_4 = A4;
-const byte PIN_BUTTON_5 = 9;
-const byte ROTARY_3_A = 2; // 30-step rotary encoder knobs have A and B encoded outputs
-const byte ROTARY_3_B = 11;
-const byte ROTARY_2_A = 3; // pins 2, 3, and 7 are interrupt-capable; we use them for Rotary 1/2/3 Code A.
-const byte ROTARY_2_B = 16;
-const byte ROTARY_1_A = 7; // knobs are numbered back-to-front, so they read left-to-right looking at the end of the Stompbox
-const byte ROTARY_1_B = A5;
-const byte PIN_KNOB_SELECT_3 = 4; // rotary knobs can also push-to-select, a "button" input
-const byte PIN_KNOB_SELECT_2 = 6;
-const byte PIN_KNOB_SELECT_1 = 8;
-const byte PIN_PEDAL_X = A0; // integrated "pedal" joystick depressed left, i.e. SW (@#@? these 2 might be backwards, but neither is working now so who knows?)
-const byte PIN_PEDAL_Y = A1; // integrated "pedal" joystick depressed right, i.e. SE
-const byte PIN_PEDAL_Z = A2; // external expression pedal input (note: pedal polarity may vary, software must be adjustable)
-const byte PIN_PEDAL_SELECT = 15; // integrated "pedal" joystick has push-to-select button input. (may be ergonomically prone to accidental presses)
-
-// the same pins grouped for bulk processing...
-
-const byte PIN_BUTTON[NUM_BUTTONS] = {
-  PIN_BUTTON_0, PIN_BUTTON_1, PIN_BUTTON_2, PIN_BUTTON_3, PIN_BUTTON_4, PIN_BUTTON_5,
-  PIN_KNOB_SELECT_1, PIN_KNOB_SELECT_2, PIN_KNOB_SELECT_3, PIN_PEDAL_SELECT
-};
+// arduino pin assignments: from the hardware profile (StompboxHardware.h), grouped for bulk processing...
 
-const byte PIN_PEDAL[NUM_PEDALS] = {
-  PIN_PEDAL_X, PIN_PEDAL_Y, PIN_PEDAL_Z
-};
-
-// symbols for those indices
-const int PEDAL_X = 0;
-const int PEDAL_Y = 1;
-const int PEDAL_Z = 2;
-
-const byte PIN_ROTARY_A[NUM_KNOBS] = {
-  ROTARY_1_A, ROTARY_2_A, ROTARY_3_A
-};
-
-const byte PIN_ROTARY_B[NUM_KNOBS] = {
-  ROTARY_1_B, ROTARY_2_B, ROTARY_3_B
-};
+const byte *const PIN_BUTTON = HW_BUTTON_PINS.pin; // array order: see HW_BUTTON
+const byte *const PIN_PEDAL = HW_PEDAL_PIN;
 
 // fx parameter number for a particular control we're interested in, 'The Anvil' amp's channel select
 const int FXPARAM_ANVIL_AMP_INDEX = 9;
@@ -217,6 +230,40 @@ const int FXPARAM_ANVIL_AMP_CHANNEL = 2;
 const int FXPARAM_OVERDRIVE_INDEX = 6;
 const int FXPARAM_OVERDRIVE_DRIVE = 2;
 
+// joystick control axes' targets on track 1 (with STOMPBOX_JOYSTICK): { fx, fxparam, curve } per axis, after the 45 degree rotation.
+// axis 0 takes the wah the external pedal was meant for; axis 1, the overdrive's drive. Adjust to taste.
+const joystick_configuration_s JOYSTICK_CONTROL[NUM_JOYSTICK_AXES] = {
+  { 2, 1, CURVE_EXP },
+  { FXPARAM_OVERDRIVE_INDEX, FXPARAM_OVERDRIVE_DRIVE, CURVE_S }
+};
+
+// (smoothing of the pedal inputs, and their change threshold: PEDAL_MIN_CUTOFF etc., in StompboxOneEuro.h)
+
+// external expression pedal's response curve (see StompboxCurves.h): wah and volume sweeps want an audio taper
+const response_curve_e PEDAL_Z_CURVE = CURVE_EXP;
+
+// external expression pedal's job. @#@#@t ignored for now: the pedal sends lots of messages, even when unplugged.
+const pedal_mode_e PEDAL_Z_MODE = IGNORED_PEDAL;
+
+// MORPH_PEDAL scenes: up to MAX_MORPH_TARGETS of { fx, fxparam, heel-down value, toe-down value } on track 1,
+// values 0-65535 for 0.0-1.0. For example, the overdrive from a rhythm setting to a lead setting. Adjust to taste.
+const morph_target_s MORPH_TARGETS[] = {
+  { FXPARAM_OVERDRIVE_INDEX, FXPARAM_OVERDRIVE_DRIVE, 13107, 52429 },     // drive 0.2 -> 0.8
+  { FXPARAM_OVERDRIVE_INDEX, FXPARAM_OVERDRIVE_DRIVE + 1, 39322, 29491 }, // tone 0.6 -> 0.45
+  { FXPARAM_OVERDRIVE_INDEX, FXPARAM_OVERDRIVE_DRIVE + 2, 32768, 45875 }  // level 0.5 -> 0.7
+};
+const int NUM_MORPH_TARGETS = sizeof(MORPH_TARGETS) / sizeof(MORPH_TARGETS[0]);
+
+// relative knob targets (0 = none: knob stays absolute).
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+// MIDI: the CC each knob sends relative steps on. MIDI-learn the fx parameter from it in Reaper, mode "Relative 2".
+const int RELATIVE_KNOB_CONTROL[NUM_KNOBS] = { 41, 42, 43 };
+#else
+// OSC: a Reaper action ID per knob, triggered via ACTION_RELATIVE (f/action/@/cc/relative): any action that accepts relative MIDI CC.
+// Fill in the IDs from Reaper's action list.
+const int RELATIVE_KNOB_CONTROL[NUM_KNOBS] = { 0, 0, 0 };
+#endif
+
 // ** globals **
 
 // current (after scan_controls) state of each button (including select press on knobs and joystick, see PIN_BUTTON for the array order)
@@ -225,8 +272,18 @@ button_state_e button_state[NUM_BUTTONS];
 // current state of each pedal: current value and how far it's changed since last reading.
 pedal_state_s pedal_state[NUM_PEDALS];
 
+// each pedal input's smoothing
+PedalFilter pedal_filter[NUM_PEDALS];
+
 // current state of each knob: current value and how far it's changed since last reading, plus the raw rotary code data.
-knob_state_s knob_state[NUM_KNOBS];
+// (written by the rotary interrupt handlers: volatile, and the loop must only touch it with interrupts off; see takeKnobChanges)
+volatile knob_state_s knob_state[NUM_KNOBS];
+
+// the joystick's calibration and control axes
+joystick_s joystick;
+
+// the pedal morph's scenes and sending state
+morph_s morph;
 
 // current state of DAW (based on OSC feedback)
 daw_state_s daw_state;
@@ -237,6 +294,12 @@ button_configuration_s button_config[NUM_BUTTONS];
 // behavior modes and control targets of the knobs
 knob_configuration_s knob_config[NUM_KNOBS];
 
+// has the configuration changed since boot (meta knobs, or pushed from the PC)? If not, it's the defaults from setupControls.
+bool config_changed = false;
+
+// lamps the host has taken over (see handleOSC_Leds): our own lamp updates leave these alone
+bool lamp_held[NUM_LEDS];
+
 // hibernation mode locks controls
 bool hibernating = false;
 
@@ -250,48 +313,54 @@ bool connected = false;
 /// rotary encoder 1A interrupt handler
 void handleRotaryInterrupt0() {
 
+  PROFILE_BEGIN(PROFILE_ROTARY_ISR);
+
   // debounce
   static time_ms previous = millis();
   time_ms current = millis();
   time_ms elapsed = current - previous;
-  if (elapsed < 1) {
-    return;
+  if (elapsed >= 1) {
+    previous = current;
+    handleKnobChange(0);
   }
-  previous = current;
 
-  handleKnobChange(0);
+  PROFILE_END(PROFILE_ROTARY_ISR);
 
 }
 
 /// rotary encoder 2A interrupt handler
 void handleRotaryInterrupt1() {
-  
+
+  PROFILE_BEGIN(PROFILE_ROTARY_ISR);
+
   // debounce
   static time_ms previous = millis();
   time_ms current = millis();
   time_ms elapsed = current - previous;
-  if (elapsed < 1) {
-    return;
+  if (elapsed >= 1) {
+    previous = current;
+    handleKnobChange(1);
   }
-  previous = current;
-  
-  handleKnobChange(1);
+
+  PROFILE_END(PROFILE_ROTARY_ISR);
 
 }
 
 /// rotary encoder 3A interrupt handler
 void handleRotaryInterrupt2() {
-  
+
+  PROFILE_BEGIN(PROFILE_ROTARY_ISR);
+
   // debounce
   static time_ms previous = millis();
   time_ms current = millis();
   time_ms elapsed = current - previous;
-  if (elapsed < 1) {
-    return;
+  if (elapsed >= 1) {
+    previous = current;
+    handleKnobChange(2);
   }
-  previous = current;
 
-  handleKnobChange(2);
+  PROFILE_END(PROFILE_ROTARY_ISR);
 
 }
 
@@ -300,28 +369,14 @@ void handleKnobChange(int ii) {
 
   // code A has just changed...
 
-  int aa = digitalRead(PIN_ROTARY_A[ii]);
-  int bb = digitalRead(PIN_ROTARY_B[ii]);
+  int aa = digitalRead(HW_KNOB[ii].pin_a);
+  int bb = digitalRead(HW_KNOB[ii].pin_b);
 
   // if code B is the same as A, knob is turning in one direction; if different, the other direction. actually pretty simple.
   int direction = (aa == bb) ? 1 : -1;
 
-  // changes are interrupt-driven and thus can arrive faster than once per loop tick.
-  // here we accumulate changes until loop consumes them.
-  knob_state[ii].delta += direction;
-  knob_state[ii].value += direction;
-  knob_state[ii].changed = true;
-
-}
+  addKnobDetent(knob_state[ii], direction);
 
-/// when loop has read and acted on knob states, we reset knob state members 'delta', 'changed', and optionally (not usually) 'value'
-void consumeKnobChanges(int ii, bool resetValue = false) {
-  
-  knob_state[ii].delta = 0;
-  knob_state[ii].changed = false;
-  if (resetValue) {
-    knob_state[ii].value = 0;
-  }
 }
 
 /// something happened to the record button
@@ -336,13 +391,51 @@ void handleRecordButtonStateChange() {
     }
     button_config[0].time_of_last_release = now;
 
-    sendRecordToggle();
+    Output::recordToggle();
   } 
 }
 
+/// something happened to a tap tempo button
+void handleTapButtonStateChange(int ii) {
+
+  if (button_state[ii] == PRESSING) {
+
+    // the moment of the press, from the pin change interrupt if this button has one (see StompboxTapTempo.h);
+    // otherwise, the moment the loop noticed it
+    time_us now = micros();
+    time_us when;
+    if (!takeTapEdge(PIN_BUTTON[ii], &when) || (now - when > TAP_TIMEOUT_US)) {
+      when = now;
+    }
+
+    float bpm = tapTempo(when);
+    if ((bpm > 0.0) && (fabs(bpm - daw_state.tempo) >= 0.1)) {
+      daw_state.tempo = bpm;
+      Output::setTempo(bpm);
+    }
+
+    // lamp flashes with the taps
+    int lamp = hwButtonLamp(ii);
+    if ((lamp >= 0) && !lamp_held[lamp]) {
+      leds[lamp] = CHSV(H_PURPLE, S_VINTAGE_LAMP, V_FULL);
+      showLEDs();
+    }
+
+  } else if (button_state[ii] == RELEASING) {
+    updateLampColors();
+  }
+
+}
+
 /// something happened to a stomp button
 void handleStompButtonStateChange(int ii) {
 
+  if (button_config[ii].button_mode == TAP_TEMPO) {
+    // taps count from the press, not the release, and have their own debouncing
+    handleTapButtonStateChange(ii);
+    return;
+  }
+
   if (button_state[ii] == RELEASING) {
       
     // debounce each button
@@ -356,10 +449,11 @@ void handleStompButtonStateChange(int ii) {
     float value;
     int value_int;
 
+    Output::beginStomp(); // may be held for the beat, if the bridge is quantising
     switch (button_config[ii].button_mode) {
 
       case FX_BYPASS:
-        sendFxBypassToggle(1, button_config[ii].fx_index);
+        Output::fxBypassToggle(1, button_config[ii].fx_index);
         break;
 
       case FXPARAM_CYCLE_3:
@@ -368,13 +462,15 @@ void handleStompButtonStateChange(int ii) {
         value_int = (value_int + 1) % 3; // cycle 0, 1, 2, 0, 1, 2...
         value = value_int / 2.0; // normalize to 0, 0.5, 1.0
         daw_state.fx_value[ii] = value;
-        sendFxParamFloat(1, button_config[ii].fx_index, button_config[ii].fx_param, value);
+        Output::setFxParam(1, button_config[ii].fx_index, button_config[ii].fx_param, value);
         break;
       
+      case TAP_TEMPO:
       case IGNORED_BUTTON:
         break;      
 
     }
+    Output::endStomp();
 
   }
 
@@ -383,52 +479,95 @@ void handleStompButtonStateChange(int ii) {
 /// something happened to a button
 void handleButtonStateChange(int ii) {
   
-  if (ii == 0) {
-    handleRecordButtonStateChange();
-  } else if (ii < 6) {
-    handleStompButtonStateChange(ii);
-  } else if (ii < 9) {
-    // knob selects 6-8
-    bool combo = checkForKnobPressCombo();
-    if (!combo) {
+  switch (HW_BUTTON[ii].role) {
+
+    case BUTTON_RECORD:
+      handleRecordButtonStateChange();
+      break;
+
+    case BUTTON_STOMP:
       handleStompButtonStateChange(ii);
-    }
-    
-  } else {
-    // joystick select
-    // best to ignore this button: probably too easily kicked unintentionally
+      break;
+
+    case BUTTON_KNOB_SELECT:
+      if (!checkForKnobPressCombo()) {
+        handleStompButtonStateChange(ii);
+      }
+      break;
+
+    case BUTTON_JOYSTICK_SELECT:
+      // best to ignore this button: probably too easily kicked unintentionally
+      break;
+
   }
 
 }
 
 /// enter a sleep state where the record button (etc.) won't be triggered accidentally
+// While hibernating we still take in the DAW's feedback (see loop), but only into daw_state: the lamps stay dark.
+// On waking, the lamps show the latest state straight after the light show.
 void hibernate(bool enterHibernation = true) {
-  
-  hibernating = enterHibernation;
-  updateLampColorsForHibernation();
+
+  LOG_EVENT(EVENT_HIBERNATE, enterHibernation);
+
+  if (enterHibernation) {
+    hibernating = true;
+    // (the host's held lamps are let go: it can send a new frame when we're back)
+    for (int ii = 0; ii < NUM_LEDS; ii++) {
+      lamp_held[ii] = false;
+    }
+    updateLampColorsForHibernation(true);
+    return;
+  }
+
+  // lamps still dark to feedback while the light show runs, and while we catch up with what came in during it...
+  updateLampColorsForHibernation(false);
+  drainInput();
+
+  // ...then show where things stand now
+  hibernating = false;
+  updateLampColors();
+  updateRecordButtonColor();
+
+}
+
+/// take in everything the host has sent (into our state) until there's nothing waiting, or for WAKE_DRAIN_LIMIT at most
+void drainInput() {
+
+  const time_ms WAKE_DRAIN_LIMIT = 50; // (in case the host sends faster than we read: don't hang on to waking for it)
+
+  time_ms start = millis();
+  while (SLIPSerial.available() && (millis() - start < WAKE_DRAIN_LIMIT)) {
+    listenForOSC();
+  }
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+  listenForMIDI();
+#endif
 
 }
 
-// press all three knob select buttons together: enter sleep mode
+// press all the knob select buttons together: enter sleep mode
+// (it happens as the first of them is let go, while the others are still down)
 bool checkForKnobPressCombo() {
-  
-  bool press_0 = ((button_state[6] == PRESSING) || (button_state[6] == PRESSED));
-  bool press_1 = ((button_state[7] == PRESSING) || (button_state[7] == PRESSED));
-  bool press_2 = ((button_state[8] == PRESSING) || (button_state[8] == PRESSED));
-  bool releasing_0 = (button_state[6] == RELEASING);
-  bool releasing_1 = (button_state[7] == RELEASING);
-  bool releasing_2 = (button_state[8] == RELEASING);
-
-  bool two_pressed_one_releasing =
-    (releasing_0 && press_1 && press_2) ||
-    (press_0 && releasing_1 && press_2) ||
-    (press_0 && press_1 && releasing_2);
-  
-  if (two_pressed_one_releasing) {
+
+  int pressed = 0;
+  int releasing = 0;
+  for (int knob = 0; knob < NUM_KNOBS; knob++) {
+    button_state_e state = button_state[hwKnobSelectButton(knob)];
+    if ((state == PRESSING) || (state == PRESSED)) {
+      pressed++;
+    } else if (state == RELEASING) {
+      releasing++;
+    }
+  }
+
+  bool all_pressed_one_releasing = (releasing == 1) && (pressed == NUM_KNOBS - 1);
+
+  if (all_pressed_one_releasing) {
     hibernate(!hibernating);
   }
 
-  return two_pressed_one_releasing;
+  return all_pressed_one_releasing;
 }
 
 /// set up data structure to track remote DAW's status
@@ -436,6 +575,7 @@ void setupDawState() {
   
   // we're guessing about this initially
   daw_state.recording = false;
+  daw_state.tempo = 0.0;
 
   // we're guessing about these initially
   for (int ii = 2; ii <= 8; ii++) {
@@ -447,25 +587,34 @@ void setupDawState() {
 /// configure buttons with default behavior modes and control targets
 void setupButtons() {
 
-  // note: record button (button 0) is not included in this scheme
+  // note: record button is not included in this scheme
   // most buttons are FX bypass buttons, emulating the fundamental control scheme of a guitar pedalboard
-  for (int ii = 1; ii <= 8; ii++) {
+  for (int ii = 0; ii < NUM_BUTTONS; ii++) {
     button_config[ii].button_mode = FX_BYPASS;
-    // to work around a reaper/OSC glitch, we only control FX #3 and up.
-    // default FX to bypass per button: 3, 4, 5, 6, (7), 6, 7, 8
-    button_config[ii].fx_index = (ii > 5) ? ii : ii + 2; 
     button_config[ii].time_of_last_release = millis();
     // .fx_param irrelevant for this mode
-  }
 
-  // exception: amp channel button (button 5)
-  button_config[5].button_mode = FXPARAM_CYCLE_3;
-  button_config[5].fx_index = FXPARAM_ANVIL_AMP_INDEX; // 'The Anvil' amp: current position in fx chain
-  button_config[5].fx_param = FXPARAM_ANVIL_AMP_CHANNEL; // amp: channel select control
+    // to work around a reaper/OSC glitch, we only control FX #3 and up.
+    // default FX to bypass per button: stomps from 3 up (the original board: 3, 4, 5, 6, (7)); knob selects, the last few (6, 7, 8)
+    switch (HW_BUTTON[ii].role) {
+      case BUTTON_STOMP:
+        button_config[ii].fx_index = min(FIRST_FX_INDEX + (ii - FIRST_STOMP_BUTTON), LAST_FX_INDEX);
+        break;
+      case BUTTON_KNOB_SELECT:
+        button_config[ii].fx_index = LAST_FX_INDEX - NUM_KNOBS + 1 + HW_BUTTON[ii].knob;
+        break;
+      default:
+        // exceptions: record button (see above) and joystick select button (probably too easily kicked) are ignored
+        button_config[ii].button_mode = IGNORED_BUTTON;
+        // .fx_index and .fx_param irrelevant for this mode
+        break;
+    }
+  }
 
-  // exception: joystick select button is ignored (probably too easily kicked)
-  button_config[9].button_mode = IGNORED_BUTTON;
-  // .fx_index and .fx_param irrelevant for this mode
+  // exception: amp channel button (the last stomp)
+  button_config[LAST_STOMP_BUTTON].button_mode = FXPARAM_CYCLE_3;
+  button_config[LAST_STOMP_BUTTON].fx_index = FXPARAM_ANVIL_AMP_INDEX; // 'The Anvil' amp: current position in fx chain
+  button_config[LAST_STOMP_BUTTON].fx_param = FXPARAM_ANVIL_AMP_CHANNEL; // amp: channel select control
 
 }
 
@@ -476,10 +625,12 @@ void handleMetaKnobChange(int knob, int button, int delta) {
   const int KNOB_META_PARAM = 1;
   const int KNOB_META_MODE = 2;
 
-  const int KNOB_BUTTON_OFFSET = 6; // button 6 is on knob 0, 7 on 1, 8 on 2.
-
   const float STEP_SIZE_STEP_SIZE = 0.01;
 
+  // button modes, in the order the mode knob steps through them (turning back from bypass gives cycle-3, as it always has)
+  const int NUM_META_MODES = 3;
+  const button_mode_e META_MODE_CYCLE[NUM_META_MODES] = { FX_BYPASS, TAP_TEMPO, FXPARAM_CYCLE_3 };
+
   int new_value;
   float new_step_size;
   
@@ -489,15 +640,15 @@ void handleMetaKnobChange(int knob, int button, int delta) {
   // note: we currently allow delta to be anything here, but it's probably best if it's only +1 or -1.
   // at present, the caller guarantees that, but if we change the caller, maybe we should do it here.
 
-  switch (button) {
-    case 0: 
+  switch (HW_BUTTON[button].role) {
+    case BUTTON_RECORD:
       // record button
       // no customization options yet, so knob doesn't do anything
       //  (in the future, it could cycle through behavior modes,
       //   such as whether to stop or punch-out when recording ends, etc.)
       break;
       
-    case 1: case 2: case 3: case 4: case 5:
+    case BUTTON_STOMP:
       // stomp button: meta knobs reassign it
       switch (knob) {
         case KNOB_META_INDEX:
@@ -527,61 +678,55 @@ void handleMetaKnobChange(int knob, int button, int delta) {
           break;
 
         case KNOB_META_MODE:
-          // third knob cycles button behavior mode
-          if (delta < 0) {
-          //switch (button_config[button].button_mode) {
-          //  case FX_BYPASS:
-              button_config[button].button_mode = FXPARAM_CYCLE_3;
-              
-          //    break;
-          } else {
-          //  case FXPARAM_CYCLE_3:
-              button_config[button].button_mode = FX_BYPASS;
-              
-          //    break;
-
-          //  default:
-              // IGNORED_BUTTON is for debugging; it does not participate in this cycle
-          //    break;
+          // third knob cycles button behavior mode, one mode per detent
+          // (IGNORED_BUTTON is for debugging; it does not participate in this cycle)
+          new_value = 0;
+          for (int ii = 0; ii < NUM_META_MODES; ii++) {
+            if (META_MODE_CYCLE[ii] == button_config[button].button_mode) {
+              new_value = ii;
+            }
           }
+          new_value = (new_value + ((delta < 0) ? NUM_META_MODES - 1 : 1)) % NUM_META_MODES;
+          button_config[button].button_mode = META_MODE_CYCLE[new_value];
+          updateLampColors();
           
           break;
       }
       break;
 
-    case 6: case 7: case 8:
+    case BUTTON_KNOB_SELECT:
       // knob buttons: meta knobs reassign the knobs (not the knob buttons! 
       //  we can't select both knob and button; knob is more important)
       switch (knob) {
         case KNOB_META_INDEX:
           // first knob sets knob's target fx
-          new_value = knob_config[button - KNOB_BUTTON_OFFSET].fx + delta;
+          new_value = knob_config[HW_BUTTON[button].knob].target[0].fx + delta;
           // constrain to fx we can control
           if (new_value < FIRST_FX_INDEX) {
             new_value = FIRST_FX_INDEX;
           } else if (new_value > LAST_FX_INDEX) {
             new_value = LAST_FX_INDEX;
           }
-          knob_config[button - KNOB_BUTTON_OFFSET].fx = new_value;
+          knob_config[HW_BUTTON[button].knob].target[0].fx = new_value;
           
           break;
 
         case KNOB_META_PARAM:
           // second knob sets knob's target fx parameter
-          new_value = knob_config[button - KNOB_BUTTON_OFFSET].fxparam + delta;
+          new_value = knob_config[HW_BUTTON[button].knob].target[0].fxparam + delta;
           if (new_value < 1) {
             new_value = 1;
           } else if (new_value > 255) {
             // Adjust to taste: I have no idea how many fxparams an fx can actually have, or realistically would have
             new_value = 255;
           }
-          knob_config[button - KNOB_BUTTON_OFFSET].fxparam = new_value;
+          knob_config[HW_BUTTON[button].knob].target[0].fxparam = new_value;
           
           break;
 
         case KNOB_META_MODE:
           // third knob sets knob's scale per tick? knob mode?
-          new_step_size = knob_config[button - KNOB_BUTTON_OFFSET].step_size + ((float)delta * STEP_SIZE_STEP_SIZE);
+          new_step_size = knob_config[HW_BUTTON[button].knob].step_size + ((float)delta * STEP_SIZE_STEP_SIZE);
           if (new_step_size < 0.01) {
             // in a normalized fxparam, what's the actual useful minimum knob step size? 0.01? 0.001?
             new_step_size = 0.01;
@@ -589,23 +734,32 @@ void handleMetaKnobChange(int knob, int button, int delta) {
             // in a normalized fxparam, what's the actual useful maximum knob step size? 0.1? 0.5?
             new_step_size = 1.0;
           }
-          knob_config[button - KNOB_BUTTON_OFFSET].step_size = new_step_size;
+          knob_config[HW_BUTTON[button].knob].step_size = new_step_size;
           
           break;
       }
       break;
     
-    case 9:
+    case BUTTON_JOYSTICK_SELECT:
       // joystick select button
       // not used, so not configurable
       break;
       
   }
+
+  config_changed = true;
 }
 
 /// a knob has been turned
 void handleKnobChange(int knob, int delta) {
 
+  if (knob_config[knob].knob_mode == RELATIVE_KNOB) {
+    // the DAW knows the true value; we just say which way and how far
+    Output::relativeControl(knob_config[knob].relative_control, delta);
+    return;
+  }
+
+  // (we track the knob's position; the fx parameter gets that position through the knob's response curve)
   daw_state.fx_knob[knob].value = (daw_state.fx_knob[knob].value + knob_config[knob].step_size * delta);
   if (daw_state.fx_knob[knob].value > 1.01) {
     daw_state.fx_knob[knob].value = 1.0;
@@ -613,7 +767,23 @@ void handleKnobChange(int knob, int delta) {
     daw_state.fx_knob[knob].value = 0.0;
   }
 
-  sendFxParamFloat(1, knob_config[knob].fx, knob_config[knob].fxparam, daw_state.fx_knob[knob].value);
+  // several targets go out as one update, so they change together rather than one paced message apart
+  bool grouped = (knob_config[knob].num_targets > 1);
+  if (grouped) {
+    Output::beginGroup();
+  }
+  for (int ii = 0; ii < knob_config[knob].num_targets; ii++) {
+    const knob_target_s *target = &knob_config[knob].target[ii];
+    float value = responseCurveUnit(target->curve, daw_state.fx_knob[knob].value);
+    if (target->inverted) {
+      value = 1.0 - value;
+    }
+    value = target->minimum + (target->maximum - target->minimum) * value;
+    Output::setFxParam(1, target->fx, target->fxparam, value);
+  }
+  if (grouped) {
+    Output::endGroup();
+  }
 
 }
 
@@ -638,21 +808,49 @@ void setupControls() {
     daw_state.fx_knob[ii].value = 0.5;
     
     // for now, default to controlling Drive/Tone/Level on TS-999, fx #4 on track 1
-    knob_config[ii].fx = FXPARAM_OVERDRIVE_INDEX;
-    knob_config[ii].fxparam = FXPARAM_OVERDRIVE_DRIVE + ii;
+    knob_config[ii].target[0] = { FXPARAM_OVERDRIVE_INDEX, FXPARAM_OVERDRIVE_DRIVE + ii, 0.0, 1.0, false, CURVE_LINEAR };
+    knob_config[ii].num_targets = 1;
     knob_config[ii].step_size = 0.04;
+
+    // relative mode, if built for it and the knob has a target (see StompboxConfig.h)
+    knob_config[ii].relative_control = RELATIVE_KNOB_CONTROL[ii];
+    knob_config[ii].knob_mode = (STOMPBOX_RELATIVE_KNOBS && (RELATIVE_KNOB_CONTROL[ii] != 0)) ? RELATIVE_KNOB : ABSOLUTE_KNOB;
+  }
+
+  // e.g. make the first knob a "gain" knob, raising drive while lowering the output level to match:
+  //knob_config[0].target[1] = { FXPARAM_OVERDRIVE_INDEX, FXPARAM_OVERDRIVE_DRIVE + 2, 0.3, 0.7, true, CURVE_LINEAR };
+  //knob_config[0].num_targets = 2;
+
+  // (one handler per knob: up to three, see StompboxHardware.h)
+  void (*const rotary_interrupt[3])() = { handleRotaryInterrupt0, handleRotaryInterrupt1, handleRotaryInterrupt2 };
+  for (int ii = 0; ii < NUM_KNOBS; ii++) {
+    attachInterrupt(digitalPinToInterrupt(HW_KNOB[ii].pin_a), rotary_interrupt[ii], CHANGE);
+  }
+
+  // timestamp button presses as they happen, where the pins allow, for tap tempo
+  setupTapCapture(PIN_BUTTON, NUM_BUTTONS);
+
+  morph.num_targets = min(NUM_MORPH_TARGETS, MAX_MORPH_TARGETS);
+  for (int ii = 0; ii < morph.num_targets; ii++) {
+    morph.target[ii] = MORPH_TARGETS[ii];
   }
+  morph.sent = false;
 
-  attachInterrupt( digitalPinToInterrupt(PIN_ROTARY_A[0]),	handleRotaryInterrupt0, CHANGE);
-  attachInterrupt( digitalPinToInterrupt(PIN_ROTARY_A[1]),	handleRotaryInterrupt1, CHANGE);
-  attachInterrupt( digitalPinToInterrupt(PIN_ROTARY_A[2]),	handleRotaryInterrupt2, CHANGE);
+#if STOMPBOX_JOYSTICK
+  // hands (and feet) off the joystick at startup, please: this is where it rests
+  calibrateJoystick(&joystick, PIN_PEDAL[PEDAL_X], PIN_PEDAL[PEDAL_Y]);
+  for (int ii = 0; ii < NUM_JOYSTICK_AXES; ii++) {
+    joystick.axis[ii].direction = 1;
+  }
+#endif
  
 } // init_controls
 
 void scanControlsWhileHibernating() {
 
-  for (int ii = 6; ii <= 8; ii++) {
+  for (int knob = 0; knob < NUM_KNOBS; knob++) {
 
+    int ii = hwKnobSelectButton(knob);
     int result = digitalRead(PIN_BUTTON[ii]);
 
     // using internal pullup resistors and grounding buttons, so 0 = make, 1 = break
@@ -681,18 +879,59 @@ void scanControlsWhileHibernating() {
 
 }
 
+/// send the joystick's two control axes as they change (rate-limited; see StompboxJoystick.h)
+void scanJoystick() {
+
+  processJoystick(&joystick, pedal_state[PEDAL_X].value, pedal_state[PEDAL_Y].value);
+
+  for (int ii = 0; ii < NUM_JOYSTICK_AXES; ii++) {
+    float value;
+    if (takeJoystickAxisChange(&joystick, ii, &value)) {
+      latencyCapture(LATENCY_PEDAL, pedal_state[PEDAL_X + ii].read_time);
+      value = responseCurveUnit(JOYSTICK_CONTROL[ii].curve, value);
+      Output::setFxParam(1, JOYSTICK_CONTROL[ii].fx, JOYSTICK_CONTROL[ii].fxparam, value);
+      latencyFinish();
+    }
+  }
+
+}
+
+/// send the morph's targets for the pedal's current position, when an update is due (coalesced and rate-capped; see StompboxMorph.h)
+void scanMorph() {
+
+  // reverse direction, then through the pedal's curve
+  uint16_t position = responseCurve(PEDAL_Z_CURVE, adcToCurvePosition(1023 - pedal_state[PEDAL_Z].value));
+  if (!takeMorphUpdate(&morph, position)) {
+    return;
+  }
+
+  // all targets in one update
+  latencyCapture(LATENCY_PEDAL, pedal_state[PEDAL_Z].read_time);
+  Output::beginGroup();
+  for (int ii = 0; ii < morph.num_targets; ii++) {
+    float value = morphValue(&morph.target[ii], position) / 65535.0;
+    Output::setFxParam(1, morph.target[ii].fx, morph.target[ii].fxparam, value);
+  }
+  Output::endGroup();
+  latencyFinish();
+
+}
+
 /// poll all controls once for changes
 void scanControls() {
 
-  // buttons
+  PROFILE_BEGIN(PROFILE_SCAN_CONTROLS);
+
+  // buttons (all read together, straight from the ports; see StompboxHardware.h)
+
+  uint16_t pressed = hwReadButtons();
 
   for (int ii = 0; ii < NUM_BUTTONS; ii++) {
 
-    int result = digitalRead(PIN_BUTTON[ii]);
     int was = button_state[ii];
 
-    // using internal pullup resistors and grounding buttons, so 0 = make, 1 = break
-    if (result == 0) {
+    // using internal pullup resistors and grounding buttons: a set bit is a make
+    if (pressed & (1u << ii)) {
       // button is depressed
       if (button_state[ii] == PRESSING) {
         // caller had a chance to respond to PRESSING state after last call, so we can move on.
@@ -713,7 +952,14 @@ void scanControls() {
     }
 
     if (button_state[ii] != was) {
-       handleButtonStateChange(ii);
+      if (button_state[ii] == PRESSING) {
+        LOG_EVENT(EVENT_PRESS, ii);
+      } else if (button_state[ii] == RELEASING) {
+        LOG_EVENT(EVENT_RELEASE, ii);
+      }
+      latencyCapture(LATENCY_BUTTON, micros());
+      handleButtonStateChange(ii);
+      latencyFinish();
     }
   }
 
@@ -721,43 +967,64 @@ void scanControls() {
 
   for (int ii = 0; ii < NUM_PEDALS; ii++) {
 
-    const int threshold = 20;
-
     analogRead(PIN_PEDAL[ii]); // @#@? some sources recommend an extra read to stabilize ADC. We could test this.
     int result = analogRead(PIN_PEDAL[ii]); 
+    pedal_state[ii].read_time = micros();
+
+    // smoothed: steady at rest, close behind the foot in a sweep. (filtered as a 16-bit position, back to 0-1023 here)
+    result = pedal_filter[ii].filter(adcToCurvePosition(result), pedal_state[ii].read_time) >> 6;
+
+#if STOMPBOX_JOYSTICK
+    if ((ii == PEDAL_X) || (ii == PEDAL_Y)) {
+      // the joystick takes every (smoothed) reading: its deadzone and rate limit do the rest (see scanJoystick)
+      pedal_state[ii].delta = result - pedal_state[ii].value;
+      pedal_state[ii].value = result;
+      continue;
+    }
+#endif
   
     int was = pedal_state[ii].value;
     int delta = result - was;
 
-    if (abs(delta) > threshold) {
+    if (abs(delta) > PEDAL_THRESHOLD) {
 
       pedal_state[ii].value = result;
 
       if (ii == PEDAL_Z) {
-        float answer = pedal_state[ii].value / 1023.0;
-        answer = 1.0 - answer; // reverse direction
 
-        // @#@#@t pedal disabled for now: pedal sends lots of messages, even when unplugged. May be causing OSC errors.
-        //sendWah(answer);
+        if (PEDAL_Z_MODE == FXPARAM_PEDAL) {
+          // reverse direction, then through the pedal's curve
+          float answer = responseCurve(PEDAL_Z_CURVE, adcToCurvePosition(1023 - pedal_state[ii].value)) / 65535.0;
+          latencyCapture(LATENCY_PEDAL, pedal_state[ii].read_time);
+          Output::setFxParam(1, 2, 1, answer); // "NA Wah" fx plugin (currently hardcoded) at position 2
+          latencyFinish();
+        }
+        // (MORPH_PEDAL: see scanMorph)
 
       } else {
         // @#@u PEDAL_X and PEDAL_Y (the joystick) are not working. Possibly a wiring problem.
-        // The joystick is an optional bonus feature anyway, so for now we ignore these non-functional inputs. 
+        // The joystick is an optional bonus feature anyway, so unless built with STOMPBOX_JOYSTICK, we ignore these inputs.
       }
        
     }
   }
 
-  // knobs
+  if (PEDAL_Z_MODE == MORPH_PEDAL) {
+    scanMorph();
+  }
+
+#if STOMPBOX_JOYSTICK
+  scanJoystick();
+#endif
 
-//  byte oldSREG = SREG; // save interrupts status (on or off; likely on)
-//	noInterrupts(); // protect event buffer integrity
+  // knobs
 
   for (int ii = 0; ii < NUM_KNOBS; ii++) {
     
-    if (knob_state[ii].changed) {
-      
-      int delta = knob_state[ii].delta;
+    time_us edge_time;
+    int delta = takeKnobChanges(knob_state[ii], &edge_time);
+
+    if (delta != 0) {
 
       // disallow skips
       // @#@? this is a matter of taste. If the user spins the knob fast, do we try to keep up?
@@ -768,6 +1035,7 @@ void scanControls() {
       } else if (delta > 1) {
         delta = 1;
       }
+      LOG_EVENT(EVENT_KNOB, ii | ((delta < 0) ? 0x80 : 0));
 
       // if exactly one button is being held down when we turn the knob, treat it as a meta knob
       // (reconfiguring the corresponding control surface control rather than controlling a DAW fx parameter)
@@ -784,21 +1052,336 @@ void scanControls() {
       if (how_many_pressed_buttons == 1) {
         handleMetaKnobChange(ii, pressed_button, delta);
       } else {
+        latencyCapture(LATENCY_KNOB, edge_time);
         handleKnobChange(ii, delta);
+        latencyFinish();
       }
 
     }
-    
 
-    consumeKnobChanges(ii);
+  }
+
+  PROFILE_END(PROFILE_SCAN_CONTROLS);
 
+}
+  
+// ** configuration over OSC **
+
+/*
+  The whole control mapping as one blob, so the PC can load (or save) a rig in one message:
+    /stompbox/config ,b <blob>    replace the configuration. We reply /stompbox/config/reply ,i <config_result_e>
+    /stompbox/config/dump         we reply /stompbox/config/dump/reply ,bi <blob> <changed since boot? 0 or 1>
+  A pushed blob is checked in full before any of it is applied: it all goes in, or none of it does.
+
+  Blob layout (version 1), big-endian; fx parameter values as 16-bit fixed point (0-65535 for 0.0-1.0):
+    version, NUM_BUTTONS, NUM_KNOBS, MAX_KNOB_TARGETS, MAX_MORPH_TARGETS (1 byte each)
+    per button: mode, fx index, fx param (1 byte each)
+    per knob: mode (1), step size (2), relative control (2), number of targets (1),
+      then MAX_KNOB_TARGETS x { fx (1), fxparam (1), minimum (2), maximum (2), flags (1; bit 0 = inverted), curve (1) }
+    morph: number of targets (1), then MAX_MORPH_TARGETS x { fx (1), fxparam (1), scene A (2), scene B (2) }
+  Unused target slots are sent anyway (as zeros), so the layout never moves.
+*/
+const byte CONFIG_VERSION = 1;
+const int CONFIG_BLOB_SIZE = 5 + NUM_BUTTONS * 3 + NUM_KNOBS * (6 + MAX_KNOB_TARGETS * 8) + 1 + MAX_MORPH_TARGETS * 6;
+
+/// float 0.0-1.0 to and from the blob's 16-bit fixed point
+uint16_t configFixedPoint(float value) {
+  return (uint16_t)(constrain(value, 0.0, 1.0) * 65535.0 + 0.5);
+}
+
+float configFloat(uint16_t value) {
+  return value / 65535.0;
+}
+
+/// read a configuration blob: check all of it (apply = false), or apply all of it (apply = true: only after a clean check!)
+config_result_e readConfig(blob_cursor_s *in, bool apply) {
+
+  if ((in->size != CONFIG_BLOB_SIZE) || (blobReadByte(in) != CONFIG_VERSION)
+      || (blobReadByte(in) != NUM_BUTTONS) || (blobReadByte(in) != NUM_KNOBS)
+      || (blobReadByte(in) != MAX_KNOB_TARGETS) || (blobReadByte(in) != MAX_MORPH_TARGETS)) {
+    return CONFIG_BAD_LAYOUT;
   }
 
+  bool valid = true;
+
+  for (int ii = 0; ii < NUM_BUTTONS; ii++) {
+    byte mode = blobReadByte(in);
+    byte fx_index = blobReadByte(in);
+    byte fx_param = blobReadByte(in);
+
+    // (the same limits the meta knobs keep to; ignored and tap tempo buttons don't use their targets)
+    valid = valid && (mode <= TAP_TEMPO);
+    if (mode == FX_BYPASS) {
+      valid = valid && (fx_index >= FIRST_FX_INDEX) && (fx_index <= LAST_FX_INDEX);
+    } else if (mode == FXPARAM_CYCLE_3) {
+      // (the amp sits past the fx we bypass, so the default amp button's index is allowed too)
+      valid = valid && (fx_index >= FIRST_FX_INDEX) && (fx_index <= max(LAST_FX_INDEX, FXPARAM_ANVIL_AMP_INDEX)) && (fx_param >= 1);
+    }
+
+    if (apply) {
+      button_config[ii].button_mode = (button_mode_e)mode;
+      button_config[ii].fx_index = fx_index;
+      button_config[ii].fx_param = fx_param;
+    }
+  }
 
-//  SREG = oldSREG; // restore interrupts status
+  for (int ii = 0; ii < NUM_KNOBS; ii++) {
+    byte mode = blobReadByte(in);
+    uint16_t step_size = blobReadWord(in);
+    uint16_t relative_control = blobReadWord(in);
+    byte num_targets = blobReadByte(in);
+
+    valid = valid && (mode <= RELATIVE_KNOB) && (step_size >= configFixedPoint(0.01))
+      && (num_targets >= 1) && (num_targets <= MAX_KNOB_TARGETS)
+      && ((mode != RELATIVE_KNOB) || (relative_control != 0));
+
+    if (apply) {
+      knob_config[ii].knob_mode = (knob_mode_e)mode;
+      knob_config[ii].step_size = max(configFloat(step_size), 0.01); // (0.01 doesn't survive the round trip exactly)
+      knob_config[ii].relative_control = relative_control;
+      knob_config[ii].num_targets = num_targets;
+    }
+
+    for (int jj = 0; jj < MAX_KNOB_TARGETS; jj++) {
+      byte fx = blobReadByte(in);
+      byte fxparam = blobReadByte(in);
+      uint16_t minimum = blobReadWord(in);
+      uint16_t maximum = blobReadWord(in);
+      byte flags = blobReadByte(in);
+      byte curve = blobReadByte(in);
+
+      if (jj >= num_targets) {
+        continue; // unused slot
+      }
+      valid = valid && (fx >= 1) && (fxparam >= 1) && (curve < NUM_CURVES);
+
+      if (apply) {
+        knob_target_s *target = &knob_config[ii].target[jj];
+        target->fx = fx;
+        target->fxparam = fxparam;
+        target->minimum = configFloat(minimum);
+        target->maximum = configFloat(maximum);
+        target->inverted = (flags & 1);
+        target->curve = (response_curve_e)curve;
+      }
+    }
+  }
+
+  byte num_morph_targets = blobReadByte(in);
+  valid = valid && (num_morph_targets <= MAX_MORPH_TARGETS);
+  if (apply) {
+    morph.num_targets = num_morph_targets;
+  }
+  for (int ii = 0; ii < MAX_MORPH_TARGETS; ii++) {
+    byte fx = blobReadByte(in);
+    byte fxparam = blobReadByte(in);
+    uint16_t scene_a = blobReadWord(in);
+    uint16_t scene_b = blobReadWord(in);
+
+    if (ii >= num_morph_targets) {
+      continue; // unused slot
+    }
+    valid = valid && (fx >= 1) && (fxparam >= 1);
+
+    if (apply) {
+      morph.target[ii].fx = fx;
+      morph.target[ii].fxparam = fxparam;
+      morph.target[ii].scene_a = scene_a;
+      morph.target[ii].scene_b = scene_b;
+    }
+  }
+
+  if (in->overrun) {
+    return CONFIG_BAD_LAYOUT;
+  }
+  return valid ? CONFIG_OK : CONFIG_BAD_VALUE;
 
 }
-  
+
+/// write the current configuration as a blob (the same layout readConfig takes)
+void writeConfig(blob_cursor_s *out) {
+
+  blobWriteByte(out, CONFIG_VERSION);
+  blobWriteByte(out, NUM_BUTTONS);
+  blobWriteByte(out, NUM_KNOBS);
+  blobWriteByte(out, MAX_KNOB_TARGETS);
+  blobWriteByte(out, MAX_MORPH_TARGETS);
+
+  for (int ii = 0; ii < NUM_BUTTONS; ii++) {
+    blobWriteByte(out, button_config[ii].button_mode);
+    blobWriteByte(out, button_config[ii].fx_index);
+    blobWriteByte(out, button_config[ii].fx_param);
+  }
+
+  for (int ii = 0; ii < NUM_KNOBS; ii++) {
+    blobWriteByte(out, knob_config[ii].knob_mode);
+    blobWriteWord(out, configFixedPoint(knob_config[ii].step_size));
+    blobWriteWord(out, knob_config[ii].relative_control);
+    blobWriteByte(out, knob_config[ii].num_targets);
+    for (int jj = 0; jj < MAX_KNOB_TARGETS; jj++) {
+      bool used = (jj < knob_config[ii].num_targets);
+      const knob_target_s *target = &knob_config[ii].target[jj];
+      blobWriteByte(out, used ? target->fx : 0);
+      blobWriteByte(out, used ? target->fxparam : 0);
+      blobWriteWord(out, used ? configFixedPoint(target->minimum) : 0);
+      blobWriteWord(out, used ? configFixedPoint(target->maximum) : 0);
+      blobWriteByte(out, (used && target->inverted) ? 1 : 0);
+      blobWriteByte(out, used ? target->curve : 0);
+    }
+  }
+
+  blobWriteByte(out, morph.num_targets);
+  for (int ii = 0; ii < MAX_MORPH_TARGETS; ii++) {
+    bool used = (ii < morph.num_targets);
+    blobWriteByte(out, used ? morph.target[ii].fx : 0);
+    blobWriteByte(out, used ? morph.target[ii].fxparam : 0);
+    blobWriteWord(out, used ? morph.target[ii].scene_a : 0);
+    blobWriteWord(out, used ? morph.target[ii].scene_b : 0);
+  }
+
+}
+
+/// handle a configuration push from the PC: check it, then apply it all at once, and say how it went
+void handleOSC_Config(OSCMessage &msg) {
+
+  uint8_t blob[CONFIG_BLOB_SIZE];
+  config_result_e result = CONFIG_BAD_LAYOUT;
+
+  if (msg.isBlob(0) && (msg.getBlobLength(0) == CONFIG_BLOB_SIZE)) {
+    msg.getBlob(0, blob, CONFIG_BLOB_SIZE);
+
+    blob_cursor_s in;
+    blobStart(&in, blob, CONFIG_BLOB_SIZE);
+    result = readConfig(&in, false);
+
+    if (result == CONFIG_OK) {
+      blobStart(&in, blob, CONFIG_BLOB_SIZE);
+      readConfig(&in, true);
+
+      // what follows from the configuration, brought up to date once
+      morph.sent = false;
+      updateLampColors();
+      config_changed = true;
+    }
+  }
+  if (result != CONFIG_OK) {
+    diagnose(DIAG_CONFIG_REJECTED, result);
+  }
+
+  OSCMessage reply("/stompbox/config/reply");
+  reply.add((int32_t)result);
+  sendOSCReply(reply);
+
+}
+
+/// handle a configuration dump request from the PC
+void handleOSC_ConfigDump(OSCMessage &msg) {
+
+  uint8_t blob[CONFIG_BLOB_SIZE];
+  blob_cursor_s out;
+  blobStart(&out, blob, CONFIG_BLOB_SIZE);
+  writeConfig(&out);
+
+  OSCMessage reply("/stompbox/config/dump/reply");
+  reply.add(blob, CONFIG_BLOB_SIZE);
+  reply.add((int32_t)config_changed);
+  sendOSCReply(reply);
+
+}
+
+// ** benchmarks **
+
+/*
+  /stompbox/bench times a fixed suite on this hardware, for comparing firmware and library versions on real silicon.
+  It replies /stompbox/bench/reply ,ib <F_CPU> <blob>: (reps, total cycles, max cycles) per benchmark, 32-bit big-endian,
+  in this order:
+    one FastLED show; one analogRead pair (as scanControls reads a pedal); one full scanControls();
+    encoding and SLIP-sending a typical fxparam-sized message (not counting the pacing delay);
+    parsing and dispatching a captured Reaper feedback bundle.
+  Controls are live while it runs (don't touch them), and the DAW state the dispatch benchmark changes is put back after.
+*/
+
+// a Reaper feedback bundle as it arrives: fx 3's param 5 value and bypass
+const uint8_t BENCH_REAPER_BUNDLE[] PROGMEM = {
+  0x23, 0x62, 0x75, 0x6E, 0x64, 0x6C, 0x65, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x28, 0x2F, 0x74, 0x72, 0x61, 0x63, 0x6B, 0x2F, 0x31, 0x2F, 0x66, 0x78, 0x2F,
+  0x33, 0x2F, 0x66, 0x78, 0x70, 0x61, 0x72, 0x61, 0x6D, 0x2F, 0x35, 0x2F, 0x76, 0x61, 0x6C, 0x75,
+  0x65, 0x00, 0x00, 0x00, 0x2C, 0x66, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20,
+  0x2F, 0x74, 0x72, 0x61, 0x63, 0x6B, 0x2F, 0x31, 0x2F, 0x66, 0x78, 0x2F, 0x33, 0x2F, 0x62, 0x79,
+  0x70, 0x61, 0x73, 0x73, 0x00, 0x00, 0x00, 0x00, 0x2C, 0x66, 0x00, 0x00, 0x3F, 0x80, 0x00, 0x00
+};
+
+const int NUM_BENCHMARKS = 5;
+
+void benchLEDShow() {
+  showLEDs();
+}
+
+void benchAnalogRead() {
+  analogRead(PIN_PEDAL[PEDAL_Z]);
+  analogRead(PIN_PEDAL[PEDAL_Z]);
+}
+
+void benchScanControls() {
+  scanControls();
+}
+
+void benchOSCSend() {
+  // (a /stompbox/ address, the bridge's own, so it goes no further; about as long as "/track/1/fx/3/fxparam/5/value")
+  OSCMessage msg("/stompbox/bench/fx/3/fxparam/5");
+  msg.add(0.5f);
+  linkBeginPacket();
+  msg.send(SLIPLink);
+  linkEndPacket();
+}
+
+void benchOSCPause() {
+  delay(MINIMUM_TIME_BETWEEN_OSC_SENDS);
+}
+
+void benchOSCDispatch() {
+  OSCBundle bundle;
+  for (unsigned int ii = 0; ii < sizeof(BENCH_REAPER_BUNDLE); ii++) {
+    bundle.fill(pgm_read_byte(&BENCH_REAPER_BUNDLE[ii]));
+  }
+  dispatchBundleContents(&bundle);
+}
+
+/// handle a benchmark request: run the suite, and reply with the results
+void handleOSC_Bench(OSCMessage &msg) {
+
+  bench_result_s result[NUM_BENCHMARKS];
+
+  // (the dispatch benchmark feeds us DAW feedback, and makes it look like the DAW is there)
+  daw_state_s saved_daw_state = daw_state;
+  time_ms saved_receive_time = last_OSC_receive_time;
+
+  benchRun(&result[0], benchLEDShow, 8);
+  benchRun(&result[1], benchAnalogRead, 32);
+  benchRun(&result[2], benchScanControls, 16);
+  benchRun(&result[3], benchOSCSend, 16, benchOSCPause);
+  benchRun(&result[4], benchOSCDispatch, 8);
+
+  daw_state = saved_daw_state;
+  last_OSC_receive_time = saved_receive_time;
+  updateLampColors();
+
+  uint8_t blob[NUM_BENCHMARKS * 12];
+  blob_cursor_s out;
+  blobStart(&out, blob, sizeof(blob));
+  for (int ii = 0; ii < NUM_BENCHMARKS; ii++) {
+    blobWriteLong(&out, result[ii].reps);
+    blobWriteLong(&out, result[ii].total);
+    blobWriteLong(&out, result[ii].max);
+  }
+
+  OSCMessage reply("/stompbox/bench/reply");
+  reply.add((int32_t)F_CPU);
+  reply.add(blob, sizeof(blob));
+  sendOSCReply(reply);
+
+}
+
 // ** OSC **
 
 
@@ -810,6 +1393,7 @@ void dispatchBundleContents(OSCBundle *bundleIN) {
   bundleIN->dispatch("/record", handleOSC_Record);
   bundleIN->dispatch("/track/1/fx/*/bypass", handleOSC_FxBypass);
   bundleIN->dispatch("/track/1/fx/*/fxparam/*/value", handleOSC_FxNFxparamM);
+  bundleIN->dispatch("/stompbox/leds", handleOSC_Leds);
 }
 
 /// act on an incoming OSC message
@@ -820,6 +1404,14 @@ void dispatchMessage(OSCMessage *messageIN) {
   messageIN->dispatch("/record", handleOSC_Record);
   messageIN->dispatch("/track/1/fx/*/bypass", handleOSC_FxBypass);
   messageIN->dispatch("/track/1/fx/*/fxparam/*/value", handleOSC_FxNFxparamM);
+  messageIN->dispatch("/stompbox/leds", handleOSC_Leds);
+  messageIN->dispatch("/stompbox/config", handleOSC_Config);
+  messageIN->dispatch("/stompbox/config/dump", handleOSC_ConfigDump);
+  messageIN->dispatch("/stompbox/bench", handleOSC_Bench);
+  messageIN->dispatch("/stompbox/latency", handleOSC_Latency);
+#if STOMPBOX_EVENT_LOG
+  messageIN->dispatch("/stompbox/log", handleOSC_Log);
+#endif
 }
 
 // Handle incoming OSC messages...
@@ -828,19 +1420,54 @@ void dispatchMessage(OSCMessage *messageIN) {
 void handleOSC_Record(OSCMessage &msg) {
 
   byte status = msg.getFloat(0);
-  daw_state.recording = (status != 0.0);
-  updateRecordButtonColor();
+  handleDawRecord(status != 0.0);
 }
 
 /// make Record lamp show Record status
 void updateRecordButtonColor() {
 
+  if (hibernating || lamp_held[0]) {
+    return;
+  }
   if (daw_state.recording) {
     leds[0] = CHSV(H_RED, S_FULL, V_FULL);
   } else {
     leds[0] = CHSV(H_RED, S_FULL, V_DIM);
   }
-  FastLED.show();
+  showLEDs();
+}
+
+/// handle a lamp frame from the host: every lamp at once, in one blob, shown together
+//  /stompbox/leds ,b <frame>        set them, until our own lamp updates change them again
+//  /stompbox/leds ,bi <frame> 1     set them and hold them: our own lamp updates leave them alone
+// The frame is a palette index per lamp, or R, G, B per lamp (see setLEDFrame). Each frame replaces the last one's holds,
+// and a palette frame's LED_PALETTE_KEEP lamps go back to showing our own status: a frame of all LED_PALETTE_KEEP hands them all back.
+void handleOSC_Leds(OSCMessage &msg) {
+
+  uint8_t frame[LED_FRAME_RGB_SIZE];
+  bool set[NUM_LEDS];
+
+  if (hibernating || !msg.isBlob(0) || (msg.getBlobLength(0) > LED_FRAME_RGB_SIZE)) {
+    return;
+  }
+  int length = msg.getBlobLength(0);
+  msg.getBlob(0, frame, length);
+  if (!setLEDFrame(frame, length, set)) {
+    return;
+  }
+
+  bool hold = msg.isInt(1) && (msg.getInt(1) != 0);
+  for (int ii = 0; ii < NUM_LEDS; ii++) {
+    lamp_held[ii] = hold && set[ii];
+  }
+
+  // the rest show our own status again (they may have been held until now)
+  paintLampColors(set);
+  if (!set[0]) {
+    leds[0] = CHSV(record_color, S_FULL, daw_state.recording ? V_FULL : V_DIM);
+  }
+  showLEDs();
+
 }
 
 /// handle fx bypass status update
@@ -854,8 +1481,7 @@ void handleOSC_FxBypass(OSCMessage &msg) {
 
   // track the change
   int value = msg.getFloat(0);
-  daw_state.fx_bypass[fx] = (value == 0);
-  updateLampColors();
+  handleDawFxBypass(fx, value == 0);
 
 }
 
@@ -869,9 +1495,64 @@ void handleOSC_FxNFxparamM(OSCMessage &msg) {
   int fx = buffer[12] - '0';        // e.g. "/track/1/fx/3/fxparam/5/value" -> 3
   int fxparam = buffer[22] - '0';   // e.g. "/track/1/fx/3/fxparam/5/value" -> 5
 
-  for (int ii = 1; ii <= 8; ii++) {
+  handleDawFxParam(fx, fxparam, msg.getFloat(0));
+
+}
+
+// Handle incoming MIDI feedback (same DAW state, different wire format)...
+
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+
+void handleMIDI_Record(bool recording) {
+  handleDawRecord(recording);
+}
+
+void handleMIDI_FxBypass(int fx, bool bypassed) {
+  handleDawFxBypass(fx, bypassed);
+}
+
+void handleMIDI_FxParam(int fx, int param, float value) {
+  handleDawFxParam(fx, param, value);
+}
+
+#endif
+
+// Track DAW status, whichever transport reported it...
+
+/// DAW recording status has changed
+void handleDawRecord(bool recording) {
+
+  LOG_EVENT(EVENT_FEEDBACK_RECORD, recording);
+
+  daw_state.recording = recording;
+  updateRecordButtonColor();
+}
+
+/// DAW fx bypass status has changed
+void handleDawFxBypass(int fx, bool bypassed) {
+
+  LOG_EVENT(EVENT_FEEDBACK_BYPASS, fx);
+
+  // ignore fx we don't track
+  if ((fx < 0) || (fx > LAST_FX_INDEX)) {
+    return;
+  }
+
+  daw_state.fx_bypass[fx] = bypassed;
+  updateLampColors();
+}
+
+/// DAW fx parameter value has changed
+void handleDawFxParam(int fx, int fxparam, float value) {
+
+  LOG_EVENT(EVENT_FEEDBACK_FXPARAM, (fx << 4) | (fxparam & 0x0F));
+
+  for (int ii = 0; ii < NUM_BUTTONS; ii++) {
+    if ((HW_BUTTON[ii].role != BUTTON_STOMP) && (HW_BUTTON[ii].role != BUTTON_KNOB_SELECT)) {
+      continue;
+    }
     if ( (button_config[ii].fx_index == fx) && (button_config[ii].fx_param == fxparam) ) {
-      daw_state.fx_value[ii] = msg.getFloat(0);
+      daw_state.fx_value[ii] = value;
       updateLampColors();
     }
   }
@@ -879,7 +1560,7 @@ void handleOSC_FxNFxparamM(OSCMessage &msg) {
   /*
   for (int ii = 0; ii < NUM_KNOBS; ii++) {
     // only apply updates to knobs that are assigned to that OSC address
-    if ((knob_config[ii].fx == fx) && (knob_config[ii].fxparam == fxparam)) {
+    if ((knob_config[ii].target[0].fx == fx) && (knob_config[ii].target[0].fxparam == fxparam)) {
       // note: we'd like to confirm the feedback, but this feedback is relatively slow compared to turning a knob, 
       // so the feedback message updates can race with the knob's own updates, causing ugly glitches; 
       // can't really fix that without a somewhat more complex scheme that is tolerant of lagging updates.
@@ -898,6 +1579,22 @@ void handleOSC_FxNFxparamM(OSCMessage &msg) {
 // (as well as we can; we may not have full knowledge of the ground truth)
 void updateLampColors() {
 
+  if (hibernating) {
+    return; // (lamps dark; hibernate() brings them up to date on waking)
+  }
+  paintLampColors(lamp_held);
+  showLEDs();
+
+}
+
+/// is this fx bypassed, as far as we know? (fx we don't track, such as the amp, count as active)
+bool fxBypassed(int fx) {
+  return (fx >= 0) && (fx <= LAST_FX_INDEX) && daw_state.fx_bypass[fx];
+}
+
+/// set the lamps' colors from the status of DAW controls, except the ones marked in skip[] (doesn't show them)
+void paintLampColors(const bool skip[]) {
+
   // three pretty colors for the amp channels (clean = green, rhythm = blue, lead = hot pink)
   static CRGB amp_channel_hue[3] = {
     CHSV(H_AQUA, S_VINTAGE_LAMP, V_FULL),
@@ -905,15 +1602,24 @@ void updateLampColors() {
     CHSV(H_PINK, S_VINTAGE_LAMP, V_FULL)
   };
   
-  // set lamp colors
-  for (int ii = 1; ii <= 5; ii++) {
+  // set lamp colors (a stomp button's lamp has its number)
+  for (int ii = FIRST_STOMP_BUTTON; ii <= LAST_STOMP_BUTTON; ii++) {
+
+    if (skip[ii]) {
+      continue;
+    }
 
-    if (button_config[ii].button_mode == FXPARAM_CYCLE_3) {
+    if (button_config[ii].button_mode == TAP_TEMPO) {
+
+      // a tap tempo button's lamp glows purple (and flashes with the taps)
+      leds[ii] = CHSV(H_PURPLE, S_VINTAGE_LAMP, V_DIM);
+
+    } else if (button_config[ii].button_mode == FXPARAM_CYCLE_3) {
 
       // if a button is configured to cycle between 3 options, corresponding lamp shows one of 3 colors.
       int option = (int)(daw_state.fx_value[ii] * 2);
 
-      if (daw_state.fx_bypass[button_config[ii].fx_index]) {
+      if (fxBypassed(button_config[ii].fx_index)) {
         leds[ii] = amp_channel_hue[option].scale8(V_DIM);
       } else {
         leds[ii] = amp_channel_hue[option];
@@ -923,31 +1629,33 @@ void updateLampColors() {
 
       // the default button mode is fx bypass toggle (to emulate a row of basic stomp-on/stomp-off guitar pedals)
       // lamps reflect fx on/off status. which fx each lamp represents is set in the corresponding button's configuration.    
-      if (daw_state.fx_bypass[button_config[ii].fx_index]) {
+      if (fxBypassed(button_config[ii].fx_index)) {
         leds[ii] = CHSV(H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_DIM);
       } else {
         leds[ii] = CHSV(H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_FULL);
       } 
     }
-    FastLED.show();
   }
 
 }
 
 void setRecordColor(byte val = V_DIM) {
   record_color = connected ? H_RED : H_VIOLET;
+  if (lamp_held[0]) {
+    return;
+  }
   leds[0] = CHSV(record_color, S_FULL, val);
-  FastLED.show();
+  showLEDs();
 }
 
-void updateLampColorsForHibernation() {
+void updateLampColorsForHibernation(bool entering) {
 
   // note: we presently are relying on these light shows being slow and blocking, to heavily debounce the knob press combo
   // (that is, to give the user time to release all three knobs, so we don't oscillate in and out of the mode while the buttons are held down)
   // (this issue arises because we're looking for all buttons pressed or pressing. If we looked for, say, two pressed and one pressing,
   //  we wouldn't have to worry about debouncing. Two pressed and one releasing is another valid test, maybe even cleaner.
   //  but we want light shows here anyway, and presently light shows are slow and blocking, so this should work fine.)
-  if (hibernating) {
+  if (entering) {
     // setBuiltInLED(0); 
     hibernateLightshow();
   } else {
@@ -957,53 +1665,6 @@ void updateLampColorsForHibernation() {
   }
 }
 
-/// send an OSC message asking the DAW to start or stop recording
-void sendRecordToggle() {
-  sendOSCTrigger("/record");
-}
-
-/// send an OSC message asking the DAW to enable or disable the specified fx plugin.
-// (we send a toggle, not a requested value: our current knowledge might be a guess,
-// and this action itself will yield an OSC reply with an accurate indication of the true new state)
-void sendFxBypassToggle(int track, int fx) {
-
-  // native Reaper OSC FX_BYPASS command doesn't work, or I'm not implementing it properly.
-  // (Reaper's OSC default config file is sparsely and tersely documented, with almost no discussion of how Reaper actually behaves over OSC.) 
-  // Luckily we have the S&M commands, and this sequence seems to work:
-
-  String addr = "/action/";
-  addr = addr + (40938 + track); // track 1: action 40939; track 2: action 40940, etc. No track 0.
-  sendOSCInt(addr.c_str(), 1);
-  
-  String msg = "_S&M_FXBYP";
-  msg = msg + fx; // fx = 3 and up only for our purposes
-  sendOSCString("/action/str", msg.c_str());
-  
-}
-
-/// send an OSC message asking the DAW to set the specified fx plugin parameter to the specified (normalized float) value
-void sendFxParamFloat(int track, int fx, int param, float value) {
-
-  // Reaper OSC pattern "n/track/@/fx/@/fxparam/@/value" -- n is for normalized (0.0-1.0)
-
-  String addr = "/track/";
-  addr = addr + track;
-  addr = addr + "/fx/";
-  addr = addr + fx;
-  addr = addr + "/fxparam/";
-  addr = addr + param;
-  addr = addr + "/value";
-  sendOSCFloat(addr.c_str(), value);
-
-}
-
-/// send an OSC message controlling the "NA Wah" fx plugin (currently hardcoded) at position 2.
-void sendWah(float value) {
-  
-  sendOSCFloat("/track/1/fx/2/fxparam/1/value", value);
-
-}
-
 /// keep track of OSC traffic and warn if commands are not receiving timely feedback 
 // (indicating likely serial port disconnection: PC Bridge stopped, DAW not running, DAW OSC ports misconfigured, etc.)
 void watchForDisconnection() {
@@ -1036,7 +1697,15 @@ void watchForDisconnection() {
     connected = true;
   }
 
+  // once the bridge is there to hear it, say how the last run ended
+  static bool reset_reported = false;
+  if (connected && !reset_reported) {
+    reportResetRecord();
+    reset_reported = true;
+  }
+
   if (status_changed) {
+    LOG_EVENT(EVENT_CONNECTION, connected);
     // setBuiltInLED(connected ? 0 : 1);
     setRecordColor(V_DIM);
     status_changed = false;
@@ -1056,8 +1725,8 @@ void setupPins() {
 
   // rotary encoders have two code pins that make to ground
   for (int ii = 0; ii < NUM_KNOBS; ii++) {
-    pinMode(PIN_ROTARY_A[ii], INPUT_PULLUP);
-    pinMode(PIN_ROTARY_B[ii], INPUT_PULLUP);
+    pinMode(HW_KNOB[ii].pin_a, INPUT_PULLUP);
+    pinMode(HW_KNOB[ii].pin_b, INPUT_PULLUP);
   }
 
   // pedals are analog inputs with their own +5v and ground connections (nominal analog range endpoints; actual results may vary)
@@ -1075,7 +1744,13 @@ void setupPins() {
 /// main arduino init
 void setup() {
 
+  // (first, before anything else can overwrite what the last run left)
+  setupResetRecord();
+
   setupOSC();
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+  setupMIDI();
+#endif
 
   // activate arduino pins for input and output as appropriate
   setupPins();
@@ -1092,6 +1767,8 @@ void setup() {
   
   // ...all subsystems ready.
 
+  LOG_EVENT(EVENT_BOOT, 0);
+
   // make it clear to the user that the device has just been powered on or reset
   startupLightshow();
   
@@ -1100,19 +1777,38 @@ void setup() {
 /// main arduino loop
 void loop() {
 
+  PROFILE_BEGIN(PROFILE_LOOP);
+  noteResetLoop();
+
   if (hibernating) {
 
+    enterResetPhase(PHASE_HIBERNATING);
     scanControlsWhileHibernating();
 
+    // keep up with the DAW's feedback (it goes into daw_state; lamps stay dark), so nothing piles up for us to wake to
+    listenForOSC();
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+    listenForMIDI();
+#endif
+    serviceDiagnostics();
+
   } else {
 
     watchForDisconnection();
+    enterResetPhase(PHASE_SCAN_CONTROLS);
     scanControls();
     listenForOSC();
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+    enterResetPhase(PHASE_LISTEN_MIDI);
+    listenForMIDI();
+#endif
+    serviceDiagnostics();
 
   }
 
 //  idleAnimation(); // (optional; not real-time optimized)
+
+  PROFILE_END(PROFILE_LOOP);
  
 } // loop
 
@@ -0,0 +1,29 @@
+#include "StompboxBench.h"
+
+/// a CPU cycle count, from micros() (so in steps of 64 cycles)
+uint32_t benchCycles() {
+  return micros() * (F_CPU / 1000000L);
+}
+
+/// run a benchmark reps times, timing each; between (if any) runs after each rep, untimed
+void benchRun(bench_result_s *result, bench_function_t bench, int reps, bench_function_t between) {
+
+  result->reps = reps;
+  result->total = 0;
+  result->max = 0;
+
+  for (int ii = 0; ii < reps; ii++) {
+    uint32_t start = benchCycles();
+    bench();
+    uint32_t cycles = benchCycles() - start;
+
+    result->total += cycles;
+    if (cycles > result->max) {
+      result->max = cycles;
+    }
+    if (between) {
+      between();
+    }
+  }
+
+}
@@ -0,0 +1,23 @@
+#ifndef INCLUDED_StompboxBench_ALREADY
+
+#include "StompboxConfig.h"
+#include <Arduino.h>
+
+/*
+  Micro-benchmarks, on the real hardware: time a piece of firmware, run several times, in CPU cycles.
+  Timing is by micros() (to 4 us, 64 cycles), which is enough to compare builds; for exact counts, without a timer
+  in the way, see the simulator (StompboxProfile.h). The suite itself (what gets timed) is in Stompbox.ino: see handleOSC_Bench.
+*/
+
+typedef struct bench_result_s {
+  uint32_t reps;
+  uint32_t total;   // cycles, over all reps
+  uint32_t max;     // cycles, slowest rep
+} bench_result_s;
+
+typedef void (*bench_function_t)();
+
+void benchRun(bench_result_s *result, bench_function_t bench, int reps, bench_function_t between = NULL);
+
+#define INCLUDED_StompboxBench_ALREADY
+#endif
@@ -0,0 +1,59 @@
+#include "StompboxBlob.h"
+
+/// point a cursor at the start of a buffer
+void blobStart(blob_cursor_s *cursor, uint8_t *data, int size) {
+
+  cursor->data = data;
+  cursor->size = size;
+  cursor->offset = 0;
+  cursor->overrun = false;
+
+}
+
+uint8_t blobReadByte(blob_cursor_s *cursor) {
+
+  if (cursor->offset >= cursor->size) {
+    cursor->overrun = true;
+    return 0;
+  }
+  return cursor->data[cursor->offset++];
+
+}
+
+uint16_t blobReadWord(blob_cursor_s *cursor) {
+
+  uint16_t high = blobReadByte(cursor);
+  return (high << 8) | blobReadByte(cursor);
+
+}
+
+uint32_t blobReadLong(blob_cursor_s *cursor) {
+
+  uint32_t high = blobReadWord(cursor);
+  return (high << 16) | blobReadWord(cursor);
+
+}
+
+void blobWriteByte(blob_cursor_s *cursor, uint8_t value) {
+
+  if (cursor->offset >= cursor->size) {
+    cursor->overrun = true;
+    return;
+  }
+  cursor->data[cursor->offset++] = value;
+
+}
+
+void blobWriteWord(blob_cursor_s *cursor, uint16_t value) {
+
+  blobWriteByte(cursor, value >> 8);
+  blobWriteByte(cursor, value);
+
+}
+
+void blobWriteLong(blob_cursor_s *cursor, uint32_t value) {
+
+  blobWriteWord(cursor, value >> 16);
+  blobWriteWord(cursor, value);
+
+}
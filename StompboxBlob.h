@@ -0,0 +1,29 @@
+#ifndef INCLUDED_StompboxBlob_ALREADY
+
+#include <Arduino.h>
+
+/*
+  Reading and writing the binary blobs we exchange with the PC bridge (configuration, logs and so on):
+  a cursor over a byte buffer, big-endian like the rest of OSC. Reads and writes past the end do nothing
+  (reads give 0) and set 'overrun', so a caller can do all its reads, then check once.
+*/
+
+typedef struct blob_cursor_s {
+
+  uint8_t *data;
+  int size;
+  int offset;
+  bool overrun;
+
+} blob_cursor_s;
+
+void blobStart(blob_cursor_s *cursor, uint8_t *data, int size);
+uint8_t blobReadByte(blob_cursor_s *cursor);
+uint16_t blobReadWord(blob_cursor_s *cursor);
+uint32_t blobReadLong(blob_cursor_s *cursor);
+void blobWriteByte(blob_cursor_s *cursor, uint8_t value);
+void blobWriteWord(blob_cursor_s *cursor, uint16_t value);
+void blobWriteLong(blob_cursor_s *cursor, uint32_t value);
+
+#define INCLUDED_StompboxBlob_ALREADY
+#endif
@@ -0,0 +1,57 @@
+#ifndef INCLUDED_StompboxConfig_ALREADY
+
+// Compile-time options. Edit here (or pass -D flags) to build a different flavor of Stompbox firmware.
+
+// Transport for control output and DAW feedback:
+//  OSC: OSC over SLIP over USB serial, via the PC Bridge (node) to Reaper's OSC control surface over UDP.
+//  MIDI: class-compliant USB-MIDI, straight to Reaper's MIDI input; no bridge needed. (Requires the MIDIUSB library.)
+// Neither has been shown to be faster end to end yet (see README).
+#define STOMPBOX_TRANSPORT_OSC 0
+#define STOMPBOX_TRANSPORT_MIDI 1
+
+#ifndef STOMPBOX_TRANSPORT
+#define STOMPBOX_TRANSPORT STOMPBOX_TRANSPORT_OSC
+#endif
+
+// Knobs send detent deltas (for Reaper to apply to the parameter's true value) rather than absolute values
+// guessed from our own count. Targets are set per knob in RELATIVE_KNOB_CONTROL (Stompbox.ino).
+#ifndef STOMPBOX_RELATIVE_KNOBS
+#define STOMPBOX_RELATIVE_KNOBS 0
+#endif
+
+// The joystick as a dual expression pedal (see StompboxJoystick.h); targets are in JOYSTICK_CONTROL (Stompbox.ino).
+// Off by default: check the joystick's wiring first, or a floating input will send a stream of junk values.
+#ifndef STOMPBOX_JOYSTICK
+#define STOMPBOX_JOYSTICK 0
+#endif
+
+// Cycle-count profiling of loop phases, interrupts, OSC packets and LED updates, read by the simulator
+// (Stompbox Simulator/; see StompboxProfile.h). Marks each profiled section's start and end for it: on the device it does
+// nothing useful, so leave it off there. The simulator's Makefile turns it on.
+#ifndef STOMPBOX_PROFILE
+#define STOMPBOX_PROFILE 0
+#endif
+
+// SLIP over the 32u4's hardware UART (Serial1, pins 0 and 1) instead of USB: for the simulator, which has no USB
+// but gives the UART a virtual serial port. (The "12" board uses pins 0 and 1 for stomps: not both at once.)
+#ifndef STOMPBOX_SERIAL_UART
+#define STOMPBOX_SERIAL_UART 0
+#endif
+
+// A ring log of recent events in RAM, dumped on request over OSC (see StompboxEventLog.h). About 400 bytes of RAM.
+#ifndef STOMPBOX_EVENT_LOG
+#define STOMPBOX_EVENT_LOG 1
+#endif
+
+// The board: which buttons, knobs and lamps it has, and on which pins (see StompboxHardware.h for the profiles).
+//  ORIGINAL: record button, five stomps, three knobs, joystick, pedal input; six lamps.
+//  12: the same with seven stomps (twelve buttons), eight lamps.
+#define STOMPBOX_HARDWARE_ORIGINAL 0
+#define STOMPBOX_HARDWARE_12 1
+
+#ifndef STOMPBOX_HARDWARE
+#define STOMPBOX_HARDWARE STOMPBOX_HARDWARE_ORIGINAL
+#endif
+
+#define INCLUDED_StompboxConfig_ALREADY
+#endif
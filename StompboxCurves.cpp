@@ -0,0 +1,130 @@
+#include "StompboxCurves.h"
+
+// Curve shapes, evaluated by the compiler only...
+// (C++11 constexpr: each function is a single expression, loops are recursion, and there's no constexpr exp(),
+// so we bring our own. None of this ends up in the firmware; only the tables do.)
+
+// 32 straight segments per curve: 33 points of 16 bits, 66 bytes of flash each
+const int CURVE_SEGMENTS = 32;
+const int CURVE_POINTS = CURVE_SEGMENTS + 1;
+const int CURVE_FRACTION_BITS = 11; // 16-bit position = 5 bits of segment + 11 bits of fraction
+
+// exp/log curves: how far from a straight line. 4 gives a range of about 55:1 (35 dB), close to a pot's audio taper.
+constexpr double CURVE_STEEPNESS = 4.0;
+
+/// CURVE_USER's shape: straight lines between these (x, y) points, x ascending from 0.0 to 1.0. Adjust to taste.
+typedef struct curve_breakpoint_s {
+  double x;
+  double y;
+} curve_breakpoint_s;
+
+constexpr curve_breakpoint_s USER_CURVE_BREAKPOINTS[] = {
+  { 0.0, 0.0 },
+  { 0.3, 0.05 },
+  { 0.7, 0.6 },
+  { 1.0, 1.0 }
+};
+constexpr int NUM_USER_CURVE_BREAKPOINTS = sizeof(USER_CURVE_BREAKPOINTS) / sizeof(USER_CURVE_BREAKPOINTS[0]);
+
+/// e^x by its Taylor series (plenty of terms for x up to CURVE_STEEPNESS)
+constexpr double curveExpSeries(double x, int n, double term) {
+  return (n > 40) ? term : term + curveExpSeries(x, n + 1, term * x / (n + 1));
+}
+
+constexpr double curveExp(double x) {
+  return curveExpSeries(x, 0, 1.0);
+}
+
+constexpr double curveExpShape(double x) {
+  return (curveExp(CURVE_STEEPNESS * x) - 1.0) / (curveExp(CURVE_STEEPNESS) - 1.0);
+}
+
+/// the segment of the user curve that x falls in, interpolated
+constexpr double curveBreakpointShape(double x, int ii) {
+  return ((ii + 2 >= NUM_USER_CURVE_BREAKPOINTS) || (x <= USER_CURVE_BREAKPOINTS[ii + 1].x))
+    ? USER_CURVE_BREAKPOINTS[ii].y + (USER_CURVE_BREAKPOINTS[ii + 1].y - USER_CURVE_BREAKPOINTS[ii].y)
+        * (x - USER_CURVE_BREAKPOINTS[ii].x) / (USER_CURVE_BREAKPOINTS[ii + 1].x - USER_CURVE_BREAKPOINTS[ii].x)
+    : curveBreakpointShape(x, ii + 1);
+}
+
+/// each curve, for x from 0.0 to 1.0
+constexpr double curveShape(int curve, double x) {
+  return (curve == CURVE_LOG) ? 1.0 - curveExpShape(1.0 - x)
+    : (curve == CURVE_EXP) ? curveExpShape(x)
+    : (curve == CURVE_S) ? x * x * (3.0 - 2.0 * x)
+    : (curve == CURVE_USER) ? curveBreakpointShape(x, 0)
+    : x;
+}
+
+constexpr uint16_t curveFixedPoint(double y) {
+  return (y <= 0.0) ? 0 : (y >= 1.0) ? 65535 : (uint16_t)(y * 65535.0 + 0.5);
+}
+
+constexpr uint16_t curvePoint(int curve, int ii) {
+  return curveFixedPoint(curveShape(curve, (double)ii / CURVE_SEGMENTS));
+}
+
+// a list of indices 0..N-1 to expand the table initializers from (there's no std::index_sequence here)
+template <int... Is> struct curve_indices {};
+template <int N, int... Is> struct make_curve_indices : make_curve_indices<N - 1, N - 1, Is...> {};
+template <int... Is> struct make_curve_indices<0, Is...> {
+  typedef curve_indices<Is...> type;
+};
+
+typedef struct curve_table_s {
+  uint16_t point[CURVE_POINTS];
+} curve_table_s;
+
+template <int... Is>
+constexpr curve_table_s makeCurveTable(int curve, curve_indices<Is...>) {
+  return curve_table_s { { curvePoint(curve, Is)... } };
+}
+
+typedef make_curve_indices<CURVE_POINTS>::type curve_point_indices;
+
+// the tables themselves, in flash (in response_curve_e order)
+constexpr curve_table_s CURVE_TABLE[NUM_CURVES] PROGMEM = {
+  makeCurveTable(CURVE_LINEAR, curve_point_indices()),
+  makeCurveTable(CURVE_LOG, curve_point_indices()),
+  makeCurveTable(CURVE_EXP, curve_point_indices()),
+  makeCurveTable(CURVE_S, curve_point_indices()),
+  makeCurveTable(CURVE_USER, curve_point_indices())
+};
+
+// ...and at run time, only table lookups and integer arithmetic.
+
+/// a control position (0-65535) through a curve, to an fx parameter value (0-65535)
+uint16_t responseCurve(response_curve_e curve, uint16_t position) {
+
+  if ((curve < 0) || (curve >= NUM_CURVES)) {
+    return position;
+  }
+
+  byte segment = position >> CURVE_FRACTION_BITS;
+  uint16_t fraction = position & ((1 << CURVE_FRACTION_BITS) - 1);
+  uint16_t from = pgm_read_word(&CURVE_TABLE[curve].point[segment]);
+  uint16_t to = pgm_read_word(&CURVE_TABLE[curve].point[segment + 1]);
+
+  return from + (int32_t)(((int32_t)to - (int32_t)from) * fraction) / (1 << CURVE_FRACTION_BITS);
+
+}
+
+/// the same, for positions and values as 0.0-1.0
+float responseCurveUnit(response_curve_e curve, float position) {
+
+  if (position <= 0.0) {
+    position = 0.0;
+  } else if (position >= 1.0) {
+    position = 1.0;
+  }
+  return responseCurve(curve, (uint16_t)(position * 65535.0 + 0.5)) / 65535.0;
+
+}
+
+/// a 10-bit analog reading (0-1023) as a curve position, spread over the full 16 bits
+uint16_t adcToCurvePosition(int reading) {
+
+  uint16_t value = constrain(reading, 0, 1023);
+  return (value << 6) | (value >> 4);
+
+}
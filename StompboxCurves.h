@@ -0,0 +1,29 @@
+#ifndef INCLUDED_StompboxCurves_ALREADY
+
+#include <Arduino.h>
+
+/*
+  Response curves for continuous controls (pedals, joystick axes, knobs).
+  A straight line from control position to fx parameter rarely feels right: volume and wah sweeps want
+  something like an audio taper, drive wants its action spread out, and so on. pow() and log() per reading
+  are far too slow here, so each curve is a table of points, computed by the compiler (see StompboxCurves.cpp)
+  and kept in flash, and we interpolate between neighbouring points in fixed point.
+
+  Positions and results are 0-65535, i.e. 0.0-1.0 in 16-bit fixed point.
+*/
+
+typedef enum response_curve_e {
+  CURVE_LINEAR,                 // as it was: result = position
+  CURVE_LOG,                    // fast rise, then levelling off (mirror image of CURVE_EXP)
+  CURVE_EXP,                    // slow start, then steepening: audio taper, for volume and wah sweeps
+  CURVE_S,                      // gentle at both ends, steep through the middle (smoothstep)
+  CURVE_USER,                   // straight lines through USER_CURVE_BREAKPOINTS (StompboxCurves.cpp)
+  NUM_CURVES
+} response_curve_e;
+
+uint16_t responseCurve(response_curve_e curve, uint16_t position);
+float responseCurveUnit(response_curve_e curve, float position);
+uint16_t adcToCurvePosition(int reading);
+
+#define INCLUDED_StompboxCurves_ALREADY
+#endif
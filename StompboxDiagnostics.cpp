@@ -0,0 +1,90 @@
+#include "StompboxDiagnostics.h"
+#include "StompboxOSC.h"
+#include "StompboxLEDs.h"
+
+// how long the link must have been quiet before we send a report, so reports never crowd out control traffic
+const time_ms DIAG_IDLE_GAP = 30;
+
+// how long the warning lamp stays lit
+const time_ms DIAG_LAMP_TIME = 50;
+
+typedef struct diag_kind_s {
+  diag_severity_e severity;
+  time_ms interval;         // at most one report of this kind per interval
+} diag_kind_s;
+
+// in diag_kind_e order
+const diag_kind_s DIAG_KIND[NUM_DIAG_KINDS] = {
+  { DIAG_ERROR, 1000 },     // DIAG_OSC_BAD_START
+  { DIAG_WARNING, 5000 },   // DIAG_OSC_BAD_BUNDLE
+  { DIAG_WARNING, 1000 },   // DIAG_CONFIG_REJECTED
+  { DIAG_WARNING, 1000 },   // DIAG_LINK_CORRUPT
+  { DIAG_WARNING, 1000 },   // DIAG_LINK_LOST
+};
+
+typedef struct diag_state_s {
+  uint16_t count;           // since the last report (stops at 65535)
+  int32_t detail;           // the latest
+  time_ms first_time;       // of the first since the last report
+  time_ms report_time;      // of the last report
+} diag_state_s;
+
+diag_state_s diag_state[NUM_DIAG_KINDS];
+
+bool diag_lamp = false;
+time_ms diag_lamp_time;
+
+/// count a problem (to be reported later, by serviceDiagnostics)
+void diagnose(diag_kind_e kind, int32_t detail) {
+
+  diag_state_s *state = &diag_state[kind];
+  if (state->count == 0) {
+    state->first_time = millis();
+  }
+  if (state->count < 65535) {
+    state->count++;
+  }
+  state->detail = detail;
+
+  if (DIAG_KIND[kind].severity >= DIAG_WARNING) {
+    setBuiltInLED(true);
+    diag_lamp = true;
+    diag_lamp_time = millis();
+  }
+
+}
+
+/// from the loop: put out the warning lamp when its time's up, and send at most one report, if the link is quiet
+void serviceDiagnostics() {
+
+  time_ms now = millis();
+
+  if (diag_lamp && (now - diag_lamp_time >= DIAG_LAMP_TIME)) {
+    setBuiltInLED(false);
+    diag_lamp = false;
+  }
+
+  if (now - last_OSC_send_time < DIAG_IDLE_GAP) {
+    return;
+  }
+
+  for (int ii = 0; ii < NUM_DIAG_KINDS; ii++) {
+    diag_state_s *state = &diag_state[ii];
+    if ((state->count == 0) || (now - state->report_time < DIAG_KIND[ii].interval)) {
+      continue;
+    }
+
+    OSCMessage msg("/stompbox/diag");
+    msg.add((int32_t)DIAG_KIND[ii].severity);
+    msg.add((int32_t)ii);
+    msg.add((int32_t)state->count);
+    msg.add((int32_t)(now - state->first_time));
+    msg.add(state->detail);
+
+    state->count = 0;
+    state->report_time = now;
+    sendOSCReply(msg);
+    return; // (one per call: the rest can wait their turn)
+  }
+
+}
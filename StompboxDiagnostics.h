@@ -0,0 +1,38 @@
+#ifndef INCLUDED_StompboxDiagnostics_ALREADY
+
+#include <Arduino.h>
+
+/*
+  Diagnostics: problems the firmware notices (bad input, mostly), told to the bridge without getting in the way.
+  diagnose() only counts: it's safe anywhere, even in the middle of reading a packet. serviceDiagnostics(), from the loop,
+  sends what's been counted, one kind at a time, through the usual paced send, and only when the link has been quiet
+  for DIAG_IDLE_GAP. Each kind is reported at most once per its interval, as a total: "N of kind K in the last T ms".
+  So a burst of garbage costs a counter increment per byte, and one message a second.
+
+  /stompbox/diag ,iiiii <severity> <kind> <count> <over ms> <latest detail>
+  Warnings and errors also light the amber warning lamp for a moment (without stopping to do it).
+*/
+
+typedef unsigned long time_ms;
+
+typedef enum diag_severity_e {
+  DIAG_INFO,
+  DIAG_WARNING,
+  DIAG_ERROR
+} diag_severity_e;
+
+// what went wrong (the bridge has the same list); severities and rate limits are in StompboxDiagnostics.cpp
+typedef enum diag_kind_e {
+  DIAG_OSC_BAD_START,       // a packet started with neither '#' nor '/' (detail: the byte)
+  DIAG_OSC_BAD_BUNDLE,      // the OSC library didn't like a bundle (detail: its error code). Reaper does this now and then; see listenForOSC
+  DIAG_CONFIG_REJECTED,     // a configuration push was refused (detail: config_result_e)
+  DIAG_LINK_CORRUPT,        // a framed packet failed its CRC, or was cut short (detail: the sequence number it claimed)
+  DIAG_LINK_LOST,           // framed packets went missing (detail: how many); see StompboxLink.h
+  NUM_DIAG_KINDS
+} diag_kind_e;
+
+void diagnose(diag_kind_e kind, int32_t detail);
+void serviceDiagnostics();
+
+#define INCLUDED_StompboxDiagnostics_ALREADY
+#endif
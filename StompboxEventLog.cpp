@@ -0,0 +1,51 @@
+#include "StompboxEventLog.h"
+
+#if STOMPBOX_EVENT_LOG
+
+#include "StompboxOSC.h"
+
+event_s event_log[EVENT_LOG_SIZE];
+uint16_t event_log_next = 0; // total events logged (wraps; only its low bits index the ring)
+bool event_log_held = false; // while the log is being sent: it stays as it was when asked for
+
+/// note an event, overwriting the oldest
+void logEvent(event_type_e type, uint8_t arg) {
+
+  if (event_log_held) {
+    return;
+  }
+
+  event_s *event = &event_log[event_log_next++ & (EVENT_LOG_SIZE - 1)];
+  event->time = micros();
+  event->type = type;
+  event->arg = arg;
+
+}
+
+/// handle a log request: reply with the ring, EVENT_LOG_CHUNK bytes at a time,
+// each /stompbox/log/reply ,iiiib <now> <next> <offset> <size> <chunk>
+// now is micros() as we reply, for the events' ages; next is the slot the next event will go in (the oldest, once the ring
+// has filled; empty slots are EVENT_NONE); both are the same in every chunk. offset is where the chunk goes in the ring,
+// which is size bytes in all, sent as it sits in memory: each event 6 bytes, time little-endian.
+// (In pieces, so no reply needs a copy of the whole ring on the heap.) Nothing is logged until the last chunk is out,
+// so the chunks fit together; the log isn't cleared: ask again later for what's happened since.
+void handleOSC_Log(OSCMessage &msg) {
+
+  int32_t now = micros();
+  int32_t next = event_log_next & (EVENT_LOG_SIZE - 1);
+
+  event_log_held = true;
+  for (unsigned offset = 0; offset < sizeof(event_log); offset += EVENT_LOG_CHUNK) {
+    OSCMessage reply("/stompbox/log/reply");
+    reply.add(now);
+    reply.add(next);
+    reply.add((int32_t)offset);
+    reply.add((int32_t)sizeof(event_log));
+    reply.add((uint8_t *)event_log + offset, min((unsigned)EVENT_LOG_CHUNK, sizeof(event_log) - offset));
+    sendOSCReply(reply);
+  }
+  event_log_held = false;
+
+}
+
+#endif
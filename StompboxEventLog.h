@@ -0,0 +1,67 @@
+#ifndef INCLUDED_StompboxEventLog_ALREADY
+
+#include "StompboxConfig.h"
+#include <Arduino.h>
+
+/*
+  A flight recorder: the last EVENT_LOG_SIZE things that happened (button edges, knob detents, packets out and in,
+  DAW feedback, errors, connection changes), each stamped with micros(), in a ring in RAM.
+  Logging an event is a micros() call and a 6-byte store. /stompbox/log replies with the whole ring, a chunk per message,
+  for working out afterwards what happened, in what order, and how long it took.
+  Log from the loop only, not from interrupt handlers (there's no locking).
+  With STOMPBOX_EVENT_LOG off, LOG_EVENT compiles to nothing.
+*/
+
+// what happened (the bridge has the same list, for the dump)
+typedef enum event_type_e {
+  EVENT_NONE,               // (an empty slot)
+  EVENT_BOOT,
+  EVENT_PRESS,              // arg: button
+  EVENT_RELEASE,            // arg: button
+  EVENT_KNOB,               // arg: knob, plus 0x80 if turned down
+  EVENT_SEND,               // a packet went out; arg: messages in it
+  EVENT_RECEIVE,            // a packet came in; arg: 0 message, 1 bundle
+  EVENT_FEEDBACK_RECORD,    // arg: recording?
+  EVENT_FEEDBACK_BYPASS,    // arg: fx
+  EVENT_FEEDBACK_FXPARAM,   // arg: fx in the high 4 bits, fx param in the low 4
+  EVENT_ERROR,              // arg: event_error_e
+  EVENT_CONNECTION,         // arg: connected?
+  EVENT_HIBERNATE,          // arg: hibernating?
+  NUM_EVENT_TYPES
+} event_type_e;
+
+typedef enum event_error_e {
+  EVENT_ERROR_OSC_START = 1,  // a packet started with neither '#' nor '/'
+  EVENT_ERROR_OSC_BUNDLE,     // the OSC library didn't like a bundle (see listenForOSC)
+  EVENT_ERROR_LINK_CORRUPT,   // a framed packet failed its CRC (see StompboxLink.h)
+} event_error_e;
+
+#if STOMPBOX_EVENT_LOG
+
+#include <OSCMessage.h>
+
+// entries in the ring (a power of 2); 6 bytes of RAM each
+const int EVENT_LOG_SIZE = 64;
+
+// bytes of the ring per reply message (see handleOSC_Log)
+const int EVENT_LOG_CHUNK = 64;
+
+typedef struct event_s {
+  uint32_t time;            // micros()
+  uint8_t type;             // event_type_e
+  uint8_t arg;
+} event_s;
+
+void logEvent(event_type_e type, uint8_t arg);
+void handleOSC_Log(OSCMessage &msg);
+
+#define LOG_EVENT(type, arg) logEvent(type, arg)
+
+#else
+
+#define LOG_EVENT(type, arg)
+
+#endif
+
+#define INCLUDED_StompboxEventLog_ALREADY
+#endif
@@ -0,0 +1,230 @@
+#ifndef INCLUDED_StompboxHardware_ALREADY
+
+#include "StompboxConfig.h"
+#include <Arduino.h>
+
+/*
+  The hardware: which controls the board has, what each button is for, and which pins they're on.
+  Everything that depends on the board (counts, scan loops, lamp mapping, the knob-select gestures) comes from the
+  tables here, at compile time. To build for a different board, add a profile and select it with STOMPBOX_HARDWARE
+  (StompboxConfig.h). Adding buttons, stomps and lamps is a table edit; so is moving a pin.
+
+  Conventions the rest of the firmware relies on (checked below): the record button is button 0, the stomp buttons
+  follow it, in order, and each of those has a lamp of the same number (lamp 0 lights the record button itself).
+  Knob-select buttons name their knob. There are three pedal inputs: the joystick's two axes, then the expression pedal.
+*/
+
+// what a button is for
+typedef enum button_role_e {
+  BUTTON_RECORD,
+  BUTTON_STOMP,             // a footswitch, with a lamp
+  BUTTON_KNOB_SELECT,       // a knob's push switch
+  BUTTON_JOYSTICK_SELECT,   // the joystick's push switch
+} button_role_e;
+
+typedef struct hw_button_s {
+  uint8_t pin;
+  uint8_t role;             // button_role_e (in a byte: the table is copied to RAM)
+  int8_t knob;              // BUTTON_KNOB_SELECT: which knob it's on (otherwise -1)
+} hw_button_s;
+
+typedef struct hw_knob_s {
+  uint8_t pin_a;            // must be interrupt-capable (see setupControls)
+  uint8_t pin_b;
+} hw_knob_s;
+
+#if STOMPBOX_HARDWARE == STOMPBOX_HARDWARE_ORIGINAL
+
+// The original Stompbox (see the pinout at the top of Stompbox.ino): record, five stomps, three knobs, joystick, pedal input.
+constexpr hw_button_s HW_BUTTON[] = {
+  { A3, BUTTON_RECORD, -1 },
+  { 10, BUTTON_STOMP, -1 },
+  { 12, BUTTON_STOMP, -1 },
+  { 5, BUTTON_STOMP, -1 },
+  { A4, BUTTON_STOMP, -1 },
+  { 9, BUTTON_STOMP, -1 },
+  { 8, BUTTON_KNOB_SELECT, 0 },
+  { 6, BUTTON_KNOB_SELECT, 1 },
+  { 4, BUTTON_KNOB_SELECT, 2 },
+  { 15, BUTTON_JOYSTICK_SELECT, -1 }
+};
+
+// knobs are numbered back-to-front, so they read left-to-right looking at the end of the Stompbox
+constexpr hw_knob_s HW_KNOB[] = {
+  { 7, A5 },
+  { 3, 16 },
+  { 2, 11 }
+};
+
+#elif STOMPBOX_HARDWARE == STOMPBOX_HARDWARE_12
+
+// A wider board on the same ItsyBitsy: seven stomps (on the original's pins, plus 0 and 1: free on the 32u4, whose
+// USB serial doesn't use them), so twelve buttons and eight lamps. Check these against your own wiring.
+constexpr hw_button_s HW_BUTTON[] = {
+  { A3, BUTTON_RECORD, -1 },
+  { 10, BUTTON_STOMP, -1 },
+  { 12, BUTTON_STOMP, -1 },
+  { 5, BUTTON_STOMP, -1 },
+  { A4, BUTTON_STOMP, -1 },
+  { 9, BUTTON_STOMP, -1 },
+  { 0, BUTTON_STOMP, -1 },
+  { 1, BUTTON_STOMP, -1 },
+  { 8, BUTTON_KNOB_SELECT, 0 },
+  { 6, BUTTON_KNOB_SELECT, 1 },
+  { 4, BUTTON_KNOB_SELECT, 2 },
+  { 15, BUTTON_JOYSTICK_SELECT, -1 }
+};
+
+constexpr hw_knob_s HW_KNOB[] = {
+  { 7, A5 },
+  { 3, 16 },
+  { 2, 11 }
+};
+
+#else
+#error "unknown STOMPBOX_HARDWARE"
+#endif
+
+// the same on every board so far: joystick X and Y, external expression pedal; and the NeoPixel data pin
+constexpr uint8_t HW_PEDAL_PIN[] = { A0, A1, A2 };
+constexpr uint8_t HW_LED_DATA_PIN = 14;
+
+// ...and what follows from them
+
+constexpr int NUM_BUTTONS = sizeof(HW_BUTTON) / sizeof(HW_BUTTON[0]);
+constexpr int NUM_KNOBS = sizeof(HW_KNOB) / sizeof(HW_KNOB[0]);
+constexpr int NUM_PEDALS = sizeof(HW_PEDAL_PIN) / sizeof(HW_PEDAL_PIN[0]);
+
+// symbols for the pedal indices
+constexpr int PEDAL_X = 0;
+constexpr int PEDAL_Y = 1;
+constexpr int PEDAL_Z = 2;
+
+constexpr int hwCountButtons(button_role_e role, int ii = 0) {
+  return (ii >= NUM_BUTTONS) ? 0 : (HW_BUTTON[ii].role == role) + hwCountButtons(role, ii + 1);
+}
+
+constexpr int hwFirstButton(button_role_e role, int ii = 0) {
+  return (ii >= NUM_BUTTONS) ? -1 : (HW_BUTTON[ii].role == role) ? ii : hwFirstButton(role, ii + 1);
+}
+
+/// the button on this knob (-1 if none)
+constexpr int hwKnobSelectButton(int knob, int ii = 0) {
+  return (ii >= NUM_BUTTONS) ? -1
+    : ((HW_BUTTON[ii].role == BUTTON_KNOB_SELECT) && (HW_BUTTON[ii].knob == knob)) ? ii
+    : hwKnobSelectButton(knob, ii + 1);
+}
+
+constexpr int RECORD_BUTTON = hwFirstButton(BUTTON_RECORD);
+constexpr int FIRST_STOMP_BUTTON = hwFirstButton(BUTTON_STOMP);
+constexpr int NUM_STOMP_BUTTONS = hwCountButtons(BUTTON_STOMP);
+constexpr int LAST_STOMP_BUTTON = FIRST_STOMP_BUTTON + NUM_STOMP_BUTTONS - 1;
+constexpr int NUM_KNOB_SELECT_BUTTONS = hwCountButtons(BUTTON_KNOB_SELECT);
+
+// lamp 0 for the record button, then one per stomp button
+constexpr int NUM_LAMPS = 1 + NUM_STOMP_BUTTONS;
+
+/// this button's lamp (-1 if it has none)
+constexpr int hwButtonLamp(int button) {
+  return ((HW_BUTTON[button].role == BUTTON_RECORD) || (HW_BUTTON[button].role == BUTTON_STOMP)) ? button : -1;
+}
+
+constexpr bool hwStompsFollowRecord(int ii = FIRST_STOMP_BUTTON) {
+  return (ii > LAST_STOMP_BUTTON) || ((HW_BUTTON[ii].role == BUTTON_STOMP) && hwStompsFollowRecord(ii + 1));
+}
+
+constexpr bool hwEveryKnobHasSelect(int knob = 0) {
+  return (knob >= NUM_KNOBS) || ((hwKnobSelectButton(knob) >= 0) && hwEveryKnobHasSelect(knob + 1));
+}
+
+static_assert(RECORD_BUTTON == 0, "the record button must be button 0");
+static_assert(FIRST_STOMP_BUTTON == 1 && hwStompsFollowRecord(), "the stomp buttons must follow the record button, together");
+static_assert(hwCountButtons(BUTTON_RECORD) == 1, "one record button");
+static_assert(NUM_KNOB_SELECT_BUTTONS == NUM_KNOBS && hwEveryKnobHasSelect(), "each knob needs its select button");
+static_assert(NUM_PEDALS == 3, "pedal inputs are joystick X, Y and the expression pedal");
+static_assert(NUM_KNOBS <= 3, "a knob's A pin needs an external interrupt, and there's a handler for three (see setupControls)");
+static_assert(NUM_BUTTONS <= 16, "buttons are read into a 16-bit mask (see hwReadButtons)");
+static_assert(!STOMPBOX_SERIAL_UART || (STOMPBOX_HARDWARE != STOMPBOX_HARDWARE_12), "the UART's pins 0 and 1 are stomps on this board");
+
+// the pins grouped for bulk processing, laid out from the tables above
+// (a list of indices 0..N-1 to expand them from; there's no std::index_sequence here)
+template <int... Is> struct hw_indices {};
+template <int N, int... Is> struct make_hw_indices : make_hw_indices<N - 1, N - 1, Is...> {};
+template <int... Is> struct make_hw_indices<0, Is...> {
+  typedef hw_indices<Is...> type;
+};
+
+template <int N> struct hw_pins_s {
+  uint8_t pin[N];
+};
+
+template <int... Is>
+constexpr hw_pins_s<sizeof...(Is)> hwButtonPins(hw_indices<Is...>) {
+  return hw_pins_s<sizeof...(Is)> { { HW_BUTTON[Is].pin... } };
+}
+
+constexpr hw_pins_s<NUM_BUTTONS> HW_BUTTON_PINS = hwButtonPins(typename make_hw_indices<NUM_BUTTONS>::type());
+
+/// is this input pin low? On the 32u4, a constant pin compiles to one port read (Leonardo/ItsyBitsy pin numbering)
+inline bool hwPinLow(uint8_t pin) {
+
+#if defined(__AVR_ATmega32U4__)
+  switch (pin) {
+    case 0: return !(PIND & _BV(2));
+    case 1: return !(PIND & _BV(3));
+    case 2: return !(PIND & _BV(1));
+    case 3: return !(PIND & _BV(0));
+    case 4: return !(PIND & _BV(4));
+    case 5: return !(PINC & _BV(6));
+    case 6: return !(PIND & _BV(7));
+    case 7: return !(PINE & _BV(6));
+    case 8: return !(PINB & _BV(4));
+    case 9: return !(PINB & _BV(5));
+    case 10: return !(PINB & _BV(6));
+    case 11: return !(PINB & _BV(7));
+    case 12: return !(PIND & _BV(6));
+    case 13: return !(PINC & _BV(7));
+    case 14: return !(PINB & _BV(3));
+    case 15: return !(PINB & _BV(1));
+    case 16: return !(PINB & _BV(2));
+    case 17: return !(PINB & _BV(0));
+    case 18: return !(PINF & _BV(7)); // A0
+    case 19: return !(PINF & _BV(6));
+    case 20: return !(PINF & _BV(5));
+    case 21: return !(PINF & _BV(4));
+    case 22: return !(PINF & _BV(1));
+    case 23: return !(PINF & _BV(0)); // A5
+  }
+#endif
+  return digitalRead(pin) == LOW;
+
+}
+
+/// call f(ii) for each ii from I to N - 1, unrolled: with f inlined, each call sees a constant index
+// (so, e.g., HW_BUTTON[ii].pin is a constant, and hwPinLow of it a single port read)
+template <int I, int N> struct hw_unroll {
+  template <typename F> static inline void each(F f) {
+    f(I);
+    hw_unroll<I + 1, N>::each(f);
+  }
+};
+
+template <int N> struct hw_unroll<N, N> {
+  template <typename F> static inline void each(F f) {}
+};
+
+/// read every button at once: bit ii set if button ii is pressed (they make to ground, with pullups)
+inline uint16_t hwReadButtons() {
+
+  uint16_t pressed = 0;
+  hw_unroll<0, NUM_BUTTONS>::each([&pressed](int ii) {
+    if (hwPinLow(HW_BUTTON[ii].pin)) {
+      pressed |= (1u << ii);
+    }
+  });
+  return pressed;
+
+}
+
+#define INCLUDED_StompboxHardware_ALREADY
+#endif
@@ -0,0 +1,94 @@
+#include "StompboxJoystick.h"
+
+const int ADC_MAXIMUM = 1023;
+
+/// find the rest position: the average of a few readings, taken while nobody's touching the stick (i.e. at startup)
+void calibrateJoystick(joystick_s *stick, byte pin_x, byte pin_y) {
+
+  const int samples = 16;
+  long sum_x = 0;
+  long sum_y = 0;
+  for (int ii = 0; ii < samples; ii++) {
+    sum_x += analogRead(pin_x);
+    sum_y += analogRead(pin_y);
+  }
+  stick->center_x = sum_x / samples;
+  stick->center_y = sum_y / samples;
+
+  for (int ii = 0; ii < NUM_JOYSTICK_AXES; ii++) {
+    stick->axis[ii].value = 0.0;
+    stick->axis[ii].sent = 0.0;
+    stick->axis[ii].last_send_time = millis();
+  }
+
+}
+
+/// one raw axis reading, relative to the centre, as a fraction (-1.0 to 1.0) of the throw available on that side
+float normalizeJoystickReading(int raw, int center) {
+
+  int offset = raw - center;
+  int throw_available = (offset > 0) ? (ADC_MAXIMUM - center) : center;
+  if (throw_available <= 0) {
+    return 0.0;
+  }
+  return (float)offset / throw_available;
+
+}
+
+/// turn a raw joystick reading into values for the two control axes
+void processJoystick(joystick_s *stick, int raw_x, int raw_y) {
+
+  float x = normalizeJoystickReading(raw_x, stick->center_x);
+  float y = normalizeJoystickReading(raw_y, stick->center_y);
+
+  // radial deadzone: inside it, exactly zero; outside it, rescaled so the full throw still reaches 1.0
+  float radius = sqrt(x * x + y * y);
+  if (radius < JOYSTICK_DEADZONE) {
+    x = 0.0;
+    y = 0.0;
+  } else {
+    float scale = (radius - JOYSTICK_DEADZONE) / (1.0 - JOYSTICK_DEADZONE);
+    if (scale > 1.0) {
+      scale = 1.0;
+    }
+    x = x * scale / radius;
+    y = y * scale / radius;
+  }
+
+  // undo the 45 degree mounting
+  const float COS_45 = 0.70710678;
+  float aa = (x + y) * COS_45;
+  float bb = (y - x) * COS_45;
+
+  stick->axis[0].value = constrain(aa, -1.0, 1.0);
+  stick->axis[1].value = constrain(bb, -1.0, 1.0);
+
+}
+
+/// the axis's controlled value (0.0 at rest, 1.0 at full throw its way), if it's due to be sent: changed enough, and not too soon
+// the stick is read every loop, so a change held back now goes out on a later loop; the last value always gets there.
+bool takeJoystickAxisChange(joystick_s *stick, int axis, float *value) {
+
+  joystick_axis_s *ax = &stick->axis[axis];
+
+  float result = ax->value * ax->direction;
+  if (result < 0.0) {
+    result = 0.0;
+  }
+
+  bool settling = (result == 0.0) || (result == 1.0);
+  if ((result == ax->sent) || ((fabs(result - ax->sent) < JOYSTICK_MINIMUM_CHANGE) && !settling)) {
+    return false;
+  }
+
+  time_ms now = millis();
+  if (now - ax->last_send_time < JOYSTICK_SEND_INTERVAL) {
+    return false;
+  }
+
+  ax->sent = result;
+  ax->last_send_time = now;
+  *value = result;
+  return true;
+
+}
@@ -0,0 +1,44 @@
+#ifndef INCLUDED_StompboxJoystick_ALREADY
+
+#include <Arduino.h>
+#include "StompboxOSC.h"
+
+/*
+  The joystick as a dual expression pedal.
+  It's mounted diagonally, so a foot pushing straight ahead or to the side moves both of its raw axes;
+  we rotate the raw position by 45 degrees to get back two independent control axes, one per channel.
+  Raw readings are centred on the rest position found at startup, scaled per half-axis (the centre is rarely
+  mid-range), and pass through a radial deadzone so the stick at rest reads exactly zero on both axes.
+  Changes are rate-limited per axis: small wobbles are ignored, and the rest go out at most every
+  JOYSTICK_SEND_INTERVAL, always ending on the latest value.
+*/
+
+const int NUM_JOYSTICK_AXES = 2;
+
+const float JOYSTICK_DEADZONE = 0.08; // fraction of full throw, radially, around the centre
+const float JOYSTICK_MINIMUM_CHANGE = 0.01; // smaller changes aren't sent (except to settle at 0 or 1)
+const time_ms JOYSTICK_SEND_INTERVAL = 30; // per axis
+
+typedef struct joystick_axis_s {
+
+  float value; // -1.0 to 1.0, after calibration, deadzone and rotation
+  int direction; // which way along the axis raises the controlled value: 1 or -1
+  float sent; // 0.0 to 1.0, as last sent
+  time_ms last_send_time;
+
+} joystick_axis_s;
+
+typedef struct joystick_s {
+
+  int center_x;
+  int center_y;
+  joystick_axis_s axis[NUM_JOYSTICK_AXES];
+
+} joystick_s;
+
+void calibrateJoystick(joystick_s *stick, byte pin_x, byte pin_y);
+void processJoystick(joystick_s *stick, int raw_x, int raw_y);
+bool takeJoystickAxisChange(joystick_s *stick, int axis, float *value);
+
+#define INCLUDED_StompboxJoystick_ALREADY
+#endif
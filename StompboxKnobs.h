@@ -0,0 +1,56 @@
+#ifndef INCLUDED_StompboxKnobs_ALREADY
+
+#include <Arduino.h>
+
+typedef unsigned long time_us;
+
+/*
+  Knob detents, between the rotary interrupt handlers (which add them up) and the loop (which takes them).
+  The interrupt can land anywhere in the loop, so the loop's read and reset must be one step with interrupts held off,
+  or a detent arriving between them is lost; on an 8-bit CPU even reading an int is two steps an interrupt can land between.
+  (The host tests build this too: see Stompbox Host Tests/KnobStress.cpp.)
+*/
+
+// knob states
+typedef struct knob_state_s {
+  int value;
+  int delta;
+  int codeA;
+  int codeB;
+  int direction;
+  bool changed;
+  time_us edge_time; // micros() of the first detent since the loop last took the changes
+} knob_state_s;
+
+/// from a rotary interrupt handler: add a detent (direction +1 or -1).
+// changes are interrupt-driven and thus can arrive faster than once per loop tick: they accumulate until the loop takes them.
+inline void addKnobDetent(volatile knob_state_s &knob, int direction) {
+
+  if (!knob.changed) {
+    knob.edge_time = micros();
+  }
+  knob.delta += direction;
+  knob.value += direction;
+  knob.changed = true;
+
+}
+
+/// loop takes the knob's accumulated change (0 if none), and when it began, resetting 'delta' and 'changed' in the same breath.
+// interrupts are held off for a few cycles only; pending encoder edges are serviced right after.
+inline int takeKnobChanges(volatile knob_state_s &knob, time_us *edge_time) {
+
+  byte oldSREG = SREG; // save interrupts status (on or off; likely on)
+  noInterrupts();
+
+  int delta = knob.changed ? knob.delta : 0;
+  *edge_time = knob.edge_time;
+  knob.delta = 0;
+  knob.changed = false;
+
+  SREG = oldSREG; // restore interrupts status
+
+  return delta;
+}
+
+#define INCLUDED_StompboxKnobs_ALREADY
+#endif
@@ -1,4 +1,6 @@
 #include "StompboxLEDs.h"
+#include "StompboxProfile.h"
+#include "StompboxResetRecord.h"
 
 typedef unsigned long time_ms;
 
@@ -7,9 +9,6 @@ typedef unsigned long time_ms;
 // FastLED's all-LEDs brightness maximum/scale factor
 const byte LED_MASTER_BRIGHTNESS = 127;
 
-// total NeoPixels in display (including illuminated Record button)
-const int NUM_LEDS = 6;
-
 // ** GLOBALS **
 
 // the NeoPixel LEDs (FastLED display buffer: set these and call show to update display)
@@ -17,6 +16,29 @@ CRGB leds[NUM_LEDS];
 
 byte record_color = H_RED;
 
+// the colors a packed lamp frame can name by index: the firmware's own lamp colors, so a host can match them
+typedef struct led_palette_entry_s {
+  byte hue;
+  byte sat;
+  byte val;
+} led_palette_entry_s;
+
+const led_palette_entry_s LED_PALETTE[] PROGMEM = {
+  { H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_OFF },    // 0: off
+  { H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_DIM },    // 1: lamp, fx bypassed
+  { H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_FULL },   // 2: lamp, fx on
+  { H_RED, S_FULL, V_DIM },                     // 3: record, idle
+  { H_RED, S_FULL, V_FULL },                    // 4: record, recording
+  { H_AQUA, S_VINTAGE_LAMP, V_FULL },           // 5: amp channel: clean
+  { H_BLUE, S_VINTAGE_LAMP, V_FULL },           // 6: amp channel: rhythm
+  { H_PINK, S_VINTAGE_LAMP, V_FULL },           // 7: amp channel: lead
+  { H_PURPLE, S_VINTAGE_LAMP, V_DIM },          // 8: tap tempo
+  { H_PURPLE, S_VINTAGE_LAMP, V_FULL },         // 9: tap tempo, tapped
+  { H_VIOLET, S_FULL, V_DIM },                  // 10: not connected
+  { H_GREEN, S_FULL, V_DIM }                    // 11: hibernating
+};
+const int LED_PALETTE_SIZE = sizeof(LED_PALETTE) / sizeof(LED_PALETTE[0]);
+
 // ** glowy stuff **
 
 void setupLEDs() {
@@ -28,6 +50,18 @@ void setupLEDs() {
 
 }
 
+/// push the display buffer out to the LEDs
+// (interrupts are off for most of this: about 30 us per LED, so encoder edges can wait that long)
+void showLEDs() {
+
+  PROFILE_BEGIN(PROFILE_LED_SHOW);
+  uint8_t was_phase = enterResetPhase(PHASE_LED_SHOW);
+  FastLED.show();
+  leaveResetPhase(was_phase);
+  PROFILE_END(PROFILE_LED_SHOW);
+
+}
+
 /// brighten or darken an LED
 // animation blocks processing until complete. 
 // slowness parameter is ms of delay between change steps; change_step is size of each step. Both together control animation speed.
@@ -36,13 +70,13 @@ void glowChange(int led, byte hue, byte sat, byte val_from, byte val_to, int slo
 
   if (change_step == 0) {
     leds[led] = CHSV(hue, sat, val_to);
-    FastLED.show();
+    showLEDs();
     return;
   }
 
   for (int j = val_from; (change_step > 0) ? (j < val_to) : (j > val_to); j += change_step) {
     leds[led] = CHSV(hue, sat, j);
-    FastLED.show();
+    showLEDs();
     delay(slowness);
   }
 }
@@ -65,7 +99,7 @@ void startupLightshow() {
   for (int i = 1; i < NUM_LEDS; i++) {
     leds[i] = CHSV(H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_OFF);
   }
-  FastLED.show();
+  showLEDs();
 
   // each lamp glows on
   for (int i = 1; i < NUM_LEDS; i++) {
@@ -103,7 +137,7 @@ void hibernateLightshow() {
   // and goes out completely
   for (int i = 1; i < NUM_LEDS; i++) {
     leds[i] = CHSV(H_VINTAGE_LAMP, S_VINTAGE_LAMP, V_OFF);
-    FastLED.show();
+    showLEDs();
     delay(100);
   }
 
@@ -146,6 +180,35 @@ void idleAnimation() {
 
 }
 
+/// set the lamps from a packed frame: LED_FRAME_PALETTE_SIZE palette indices, or LED_FRAME_RGB_SIZE bytes of R, G, B.
+// set[ii] says whether lamp ii was set (a palette frame can leave some as they are). Doesn't show them: the caller does that, once.
+// false if the frame is the wrong size (and nothing is set).
+bool setLEDFrame(const uint8_t *frame, int length, bool set[]) {
+
+  if (length == LED_FRAME_RGB_SIZE) {
+    for (int ii = 0; ii < NUM_LEDS; ii++) {
+      leds[ii] = CRGB(frame[ii * 3], frame[ii * 3 + 1], frame[ii * 3 + 2]);
+      set[ii] = true;
+    }
+    return true;
+  }
+
+  if (length == LED_FRAME_PALETTE_SIZE) {
+    for (int ii = 0; ii < NUM_LEDS; ii++) {
+      // (an index past the end of the palette is taken as 'keep', too)
+      set[ii] = (frame[ii] < LED_PALETTE_SIZE);
+      if (set[ii]) {
+        leds[ii] = CHSV(pgm_read_byte(&LED_PALETTE[frame[ii]].hue), pgm_read_byte(&LED_PALETTE[frame[ii]].sat),
+          pgm_read_byte(&LED_PALETTE[frame[ii]].val));
+      }
+    }
+    return true;
+  }
+
+  return false;
+
+}
+
 /// quickly flash the built-in ('reset') LED. Intended as a debugging tool.
 void flashBuiltInLED()
 { 
@@ -2,12 +2,13 @@
 
 // NeoPixel support
 #include <FastLED.h>
+#include "StompboxHardware.h"
 
 // I hate typing uint8_t
 typedef uint8_t byte; 
 
 #define PIN_LED_BUILTIN LED_BUILTIN
-#define PIN_LED_DATA 14
+#define PIN_LED_DATA HW_LED_DATA_PIN
 
 const byte V_RECORD_IDLE = 140;
 const byte V_LAMP_IDLE = 128;
@@ -26,6 +27,15 @@ const byte H_PINK = 225;
 
 const byte H_VINTAGE_LAMP = 50;
 
+// total NeoPixels in display (including illuminated Record button): one per lamp (see StompboxHardware.h)
+const int NUM_LEDS = NUM_LAMPS;
+
+// a packed lamp frame (see setLEDFrame) is one palette index per lamp, or three bytes (R, G, B) per lamp
+const int LED_FRAME_PALETTE_SIZE = NUM_LEDS;
+const int LED_FRAME_RGB_SIZE = NUM_LEDS * 3;
+// palette index: leave this lamp as it is
+const byte LED_PALETTE_KEEP = 255;
+
 // HSV color saturations
 const byte S_VINTAGE_LAMP = 200;
 const byte S_FULL = 255;
@@ -34,8 +44,10 @@ extern CRGB leds[];
 extern byte record_color;
 
 void setupLEDs();
+void showLEDs();
 void startupLightshow();
 void hibernateLightshow();
+bool setLEDFrame(const uint8_t *frame, int length, bool set[]);
 void setBuiltInLED(bool on);
 void flashBuiltInLED();
 
@@ -0,0 +1,83 @@
+#include "StompboxLatency.h"
+#include "StompboxOSC.h"
+#include "StompboxBlob.h"
+
+latency_histogram_s latency_histogram[NUM_LATENCY_CLASSES];
+
+// the control being handled now, if any, and when its last packet went
+bool latency_pending = false;
+latency_class_e latency_kind;
+time_us latency_edge;
+time_us latency_wire;
+bool latency_sent;
+
+/// a control is about to be handled: note what kind, and when its edge was
+void latencyCapture(latency_class_e kind, time_us edge) {
+
+  latency_pending = true;
+  latency_kind = kind;
+  latency_edge = edge;
+  latency_sent = false;
+
+}
+
+/// a packet's last byte has just gone to the serial port
+void latencyWire() {
+
+  if (latency_pending) {
+    latency_wire = micros();
+    latency_sent = true;
+  }
+
+}
+
+/// the control has been handled: count it, if it sent anything
+void latencyFinish() {
+
+  if (!latency_pending) {
+    return;
+  }
+  latency_pending = false;
+  if (!latency_sent) {
+    return;
+  }
+
+  time_us elapsed = latency_wire - latency_edge;
+  latency_histogram_s *histogram = &latency_histogram[latency_kind];
+
+  int bucket = 0;
+  for (time_us rest = elapsed >> 1; (rest > 0) && (bucket < LATENCY_BUCKETS - 1); rest >>= 1) {
+    bucket++;
+  }
+  if (histogram->bucket[bucket] < 65535) {
+    histogram->bucket[bucket]++;
+  }
+  histogram->count++;
+  if (elapsed > histogram->max) {
+    histogram->max = elapsed;
+  }
+
+}
+
+/// handle a latency request: reply /stompbox/latency/reply ,b with (count, max, then each bucket's count) per kind
+// of control, big-endian (32, 32, then 16 bits each), then start over
+void handleOSC_Latency(OSCMessage &msg) {
+
+  uint8_t blob[NUM_LATENCY_CLASSES * (8 + LATENCY_BUCKETS * 2)];
+  blob_cursor_s out;
+  blobStart(&out, blob, sizeof(blob));
+
+  for (int ii = 0; ii < NUM_LATENCY_CLASSES; ii++) {
+    blobWriteLong(&out, latency_histogram[ii].count);
+    blobWriteLong(&out, latency_histogram[ii].max);
+    for (int jj = 0; jj < LATENCY_BUCKETS; jj++) {
+      blobWriteWord(&out, latency_histogram[ii].bucket[jj]);
+    }
+  }
+  memset(latency_histogram, 0, sizeof(latency_histogram));
+
+  OSCMessage reply("/stompbox/latency/reply");
+  reply.add(blob, sizeof(blob));
+  sendOSCReply(reply);
+
+}
@@ -0,0 +1,43 @@
+#ifndef INCLUDED_StompboxLatency_ALREADY
+
+#include <Arduino.h>
+#include <OSCMessage.h>
+
+/*
+  Press-to-wire latency, per kind of control: from the input edge (a button change or knob detent; a pedal or joystick
+  reading) to the last byte of the last packet it sent being handed to the USB serial port.
+  That takes in loop blocking (how long until a scan saw the edge), the handling, and pacing between packets,
+  but not the pacing delay after the last one.
+
+  Button edges are timed when a scan sees them, knob detents by their encoder interrupt (the first one since the last scan),
+  and pedal/joystick/morph updates from the reading they send, so their rate caps aren't counted.
+
+  Each kind keeps a log2 histogram (bucket k: 2^k to 2^(k+1) us) with its count and maximum.
+  /stompbox/latency replies with them all and starts over.
+*/
+
+typedef unsigned long time_us;
+
+// kinds of control (the bridge has the same list)
+typedef enum latency_class_e {
+  LATENCY_BUTTON,
+  LATENCY_KNOB,
+  LATENCY_PEDAL,            // the expression pedal, morph and joystick
+  NUM_LATENCY_CLASSES
+} latency_class_e;
+
+const int LATENCY_BUCKETS = 20; // the last bucket takes everything from 2^19 us (about half a second) up
+
+typedef struct latency_histogram_s {
+  uint32_t count;
+  uint32_t max;             // us
+  uint16_t bucket[LATENCY_BUCKETS]; // (stops counting at 65535)
+} latency_histogram_s;
+
+void latencyCapture(latency_class_e kind, time_us edge);
+void latencyWire();
+void latencyFinish();
+void handleOSC_Latency(OSCMessage &msg);
+
+#define INCLUDED_StompboxLatency_ALREADY
+#endif
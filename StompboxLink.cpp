@@ -0,0 +1,184 @@
+#include "StompboxLink.h"
+#include "StompboxOSC.h"
+#include "StompboxDiagnostics.h"
+#include <util/crc16.h>
+
+link_stats_s link_stats;
+bool link_framing = false;
+
+LinkWriter SLIPLink;
+
+// outgoing
+uint8_t link_tx_seq = 0;
+uint16_t link_tx_crc;
+
+// incoming: the packet being read
+typedef enum link_rx_e { LINK_RX_START, LINK_RX_SEQ, LINK_RX_BODY, LINK_RX_PLAIN } link_rx_e;
+
+link_rx_e link_rx = LINK_RX_START;
+uint8_t link_rx_seq;
+uint16_t link_rx_crc;
+uint8_t link_rx_held[2];    // the two most recent bytes: the CRC, if the packet ends here
+uint8_t link_rx_held_count;
+
+// incoming: the sequence so far
+bool link_rx_synced = false;
+uint8_t link_rx_next;       // the sequence number we expect next
+uint8_t link_rx_corrupt_since; // corrupt packets since the last intact one (they account for that much of a gap)
+
+/// CRC-16/CCITT-FALSE, a byte at a time (polynomial 0x1021, from 0xFFFF)
+static inline uint16_t linkCRC(uint16_t crc, uint8_t data) {
+  return _crc_xmodem_update(crc, data);
+}
+
+// Sending...
+
+size_t LinkWriter::write(uint8_t data) {
+
+  link_tx_crc = linkCRC(link_tx_crc, data);
+  return SLIPSerial.write(data);
+
+}
+
+size_t LinkWriter::write(const uint8_t *buffer, size_t size) {
+
+  for (size_t ii = 0; ii < size; ii++) {
+    write(buffer[ii]);
+  }
+  return size;
+
+}
+
+/// start an outgoing packet (instead of SLIPSerial.beginPacket): write its contents through SLIPLink
+void linkBeginPacket() {
+
+  SLIPSerial.beginPacket();
+  link_tx_crc = 0xFFFF;
+  if (link_framing) {
+    SLIPLink.write(LINK_FRAME);
+    SLIPLink.write(link_tx_seq++);
+  }
+
+}
+
+/// finish an outgoing packet (instead of SLIPSerial.endPacket)
+void linkEndPacket() {
+
+  if (link_framing) {
+    uint16_t crc = link_tx_crc;
+    SLIPSerial.write((uint8_t)(crc >> 8));
+    SLIPSerial.write((uint8_t)crc);
+    link_stats.sent++;
+  }
+  SLIPSerial.endPacket();
+
+}
+
+// Receiving...
+
+/// take the next byte of an incoming packet: true, with *out, if there's a byte for the OSC reader
+// (a plain packet's bytes go straight through; a framed packet's header and CRC never do)
+bool linkTakeByte(uint8_t data, uint8_t *out) {
+
+  switch (link_rx) {
+
+    case LINK_RX_START:
+      if (data != LINK_FRAME) {
+        link_rx = LINK_RX_PLAIN;
+        *out = data;
+        return true;
+      }
+      link_rx = LINK_RX_SEQ;
+      link_rx_crc = linkCRC(0xFFFF, data);
+      return false;
+
+    case LINK_RX_SEQ:
+      link_rx_seq = data;
+      link_rx_crc = linkCRC(link_rx_crc, data);
+      link_rx_held_count = 0;
+      link_rx = LINK_RX_BODY;
+      return false;
+
+    case LINK_RX_BODY:
+      if (link_rx_held_count < 2) {
+        link_rx_held[link_rx_held_count++] = data;
+        return false;
+      }
+      // the oldest held byte isn't part of the CRC after all
+      *out = link_rx_held[0];
+      link_rx_crc = linkCRC(link_rx_crc, *out);
+      link_rx_held[0] = link_rx_held[1];
+      link_rx_held[1] = data;
+      return true;
+
+    case LINK_RX_PLAIN:
+      *out = data;
+      return true;
+
+  }
+  return false;
+
+}
+
+/// the incoming packet has ended: is it intact? (plain packets always are; so is an empty one.) Ready for the next.
+bool linkEndOfPacket() {
+
+  link_rx_e was = link_rx;
+  link_rx = LINK_RX_START;
+  if (was == LINK_RX_PLAIN) {
+    // the bridge isn't framing (it's new, or restarted): its sequence starts afresh when it does
+    link_rx_synced = false;
+  }
+  if ((was == LINK_RX_START) || (was == LINK_RX_PLAIN)) {
+    return true;
+  }
+
+  uint16_t crc = ((uint16_t)link_rx_held[0] << 8) | link_rx_held[1];
+  if ((was != LINK_RX_BODY) || (link_rx_held_count < 2) || (crc != link_rx_crc)) {
+    link_stats.corrupt++;
+    if (link_rx_corrupt_since < 255) {
+      link_rx_corrupt_since++;
+    }
+    diagnose(DIAG_LINK_CORRUPT, link_rx_seq);
+    return false;
+  }
+
+  // where does it fall in the sequence?
+  link_stats.received++;
+  int8_t gap = (int8_t)(link_rx_seq - link_rx_next);
+  if (!link_rx_synced) {
+    link_rx_synced = true;
+  } else if (gap < 0) {
+    // late: it was counted lost when the gap it left appeared
+    link_stats.reordered++;
+    if (link_stats.lost > 0) {
+      link_stats.lost--;
+    }
+    return true;
+  } else if (gap > link_rx_corrupt_since) {
+    link_stats.lost += gap - link_rx_corrupt_since;
+    diagnose(DIAG_LINK_LOST, gap - link_rx_corrupt_since);
+  }
+  link_rx_next = link_rx_seq + 1;
+  link_rx_corrupt_since = 0;
+  return true;
+
+}
+
+/// handle a framing request from the bridge: /stompbox/link 1 (frame our packets) or 0 (don't)
+void handleOSC_Link(OSCMessage &msg) {
+  link_framing = (msg.getInt(0) != 0);
+}
+
+/// handle a link statistics request from the bridge
+void handleOSC_LinkStats(OSCMessage &msg) {
+
+  OSCMessage reply("/stompbox/link/stats/reply");
+  reply.add((int32_t)link_stats.received);
+  reply.add((int32_t)link_stats.lost);
+  reply.add((int32_t)link_stats.corrupt);
+  reply.add((int32_t)link_stats.reordered);
+  reply.add((int32_t)link_stats.sent);
+  sendOSCReply(reply);
+
+}
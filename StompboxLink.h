@@ -0,0 +1,55 @@
+#ifndef INCLUDED_StompboxLink_ALREADY
+
+#include <Arduino.h>
+#include <OSCMessage.h>
+
+/*
+  Link layer between device and bridge, inside the SLIP framing: a sequence number and a CRC on every packet,
+  so a corrupted or truncated packet is thrown away rather than misread, and lost ones are counted.
+
+  A framed packet is LINK_FRAME, a sequence number (one byte, counting up per packet, each way), the OSC packet,
+  then CRC-16/CCITT-FALSE (big-endian) of everything before it. OSC packets start with '#' or '/', so plain and framed
+  packets can't be confused: both are accepted at any time. We frame our own packets once the bridge asks
+  (/stompbox/link 1; it asks again every few seconds, so a reset device picks it up again), and the bridge
+  frames its own once it has seen one of ours.
+
+  Reading, the last two bytes of a packet are the CRC, but we can't know which bytes are the last two until the end
+  arrives: so the two most recent are held back, and the OSC reader sees each byte two bytes late.
+
+  /stompbox/link ,i <on>            frame our packets (1) or not (0)
+  /stompbox/link/stats              reply /stompbox/link/stats/reply ,iiiii <received> <lost> <corrupt> <reordered> <sent>
+  Counts are since boot, framed packets only. Lost ones are gaps in the sequence not accounted for by corrupt ones.
+*/
+
+const uint8_t LINK_FRAME = 0x01;
+
+typedef struct link_stats_s {
+  uint32_t received;        // intact framed packets
+  uint32_t lost;            // never arrived (sequence gaps)
+  uint32_t corrupt;         // bad CRC or too short: thrown away
+  uint32_t reordered;       // arrived after a later one
+  uint32_t sent;            // framed packets we've sent
+} link_stats_s;
+
+extern link_stats_s link_stats;
+extern bool link_framing;
+
+/// writes to the SLIP stream, adding each byte to the outgoing packet's CRC (see linkBeginPacket)
+class LinkWriter : public Print {
+  public:
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *buffer, size_t size);
+};
+
+extern LinkWriter SLIPLink;
+
+void linkBeginPacket();
+void linkEndPacket();
+bool linkTakeByte(uint8_t data, uint8_t *out);
+bool linkEndOfPacket();
+
+void handleOSC_Link(OSCMessage &msg);
+void handleOSC_LinkStats(OSCMessage &msg);
+
+#define INCLUDED_StompboxLink_ALREADY
+#endif
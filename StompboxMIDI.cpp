@@ -0,0 +1,175 @@
+#include "StompboxMIDI.h"
+
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+
+#include "StompboxOSC.h"
+#include "StompboxEventLog.h"
+#include "StompboxLatency.h"
+
+// MIDI CC numbers for NRPN parameter select and data entry
+const byte CC_NRPN_MSB = 99;
+const byte CC_NRPN_LSB = 98;
+const byte CC_DATA_ENTRY_MSB = 6;
+const byte CC_DATA_ENTRY_LSB = 38;
+
+// USB-MIDI event packet headers (cable 0) and statuses for the channel messages we use
+const byte USB_MIDI_CIN_CONTROL_CHANGE = 0x0B;
+const byte MIDI_STATUS_CONTROL_CHANGE = 0xB0;
+const byte USB_MIDI_CIN_PROGRAM_CHANGE = 0x0C;
+const byte MIDI_STATUS_PROGRAM_CHANGE = 0xC0;
+
+/// nothing much to open: USB-MIDI comes up with the USB connection itself
+void setupMIDI() {
+
+  last_OSC_send_time = millis();
+  last_OSC_receive_time = last_OSC_send_time;
+
+}
+
+// Send MIDI messages...
+
+bool MIDI_grouping = false; // between beginGroup() and endGroup(): hold the flush
+
+/// queue one control change event (caller flushes)
+void sendMIDIControlChange(byte control, byte value) {
+
+  midiEventPacket_t event = { USB_MIDI_CIN_CONTROL_CHANGE, (byte)(MIDI_STATUS_CONTROL_CHANGE | MIDI_CHANNEL), control, value };
+  MidiUSB.sendMIDI(event);
+
+}
+
+/// push queued events out over USB, and note the time for disconnection detection
+// (the OSC timeliness stamps track whichever transport is in use)
+void flushMIDI() {
+
+  if (MIDI_grouping) {
+    return;
+  }
+  MidiUSB.flush();
+  latencyWire();
+  LOG_EVENT(EVENT_SEND, 1);
+  last_OSC_send_time = millis();
+  // no pacing delay needed: a USB-MIDI event is 4 bytes, and the host drains them at USB speed.
+
+}
+
+/// send a CC asking the DAW to start or stop recording
+void MIDIOutput::recordToggle() {
+
+  sendMIDIControlChange(MIDI_CC_RECORD, MIDI_CC_TOGGLE);
+  flushMIDI();
+
+}
+
+/// send a CC asking the DAW to toggle bypass on the specified fx
+void MIDIOutput::fxBypassToggle(int track, int fx) {
+
+  sendMIDIControlChange(MIDI_CC_FX_BYPASS_TOGGLE_BASE + fx, MIDI_CC_TOGGLE);
+  flushMIDI();
+
+}
+
+/// send a CC setting the specified fx's bypass parameter
+void MIDIOutput::setFxBypass(int track, int fx, bool bypassed) {
+
+  sendMIDIControlChange(MIDI_CC_FX_BYPASS_BASE + fx, bypassed ? 127 : 0);
+  flushMIDI();
+
+}
+
+/// send a 14-bit NRPN setting the specified fx parameter to the specified (normalized float) value
+void MIDIOutput::setFxParam(int track, int fx, int param, float value) {
+
+  int value14 = (int)(value * 16383.0 + 0.5);
+
+  sendMIDIControlChange(CC_NRPN_MSB, fx & 0x7F);
+  sendMIDIControlChange(CC_NRPN_LSB, param & 0x7F);
+  sendMIDIControlChange(CC_DATA_ENTRY_MSB, (value14 >> 7) & 0x7F);
+  sendMIDIControlChange(CC_DATA_ENTRY_LSB, value14 & 0x7F);
+  flushMIDI();
+
+}
+
+/// send a program change recalling the specified scene
+void MIDIOutput::scene(int number) {
+
+  midiEventPacket_t event = { USB_MIDI_CIN_PROGRAM_CHANGE, (byte)(MIDI_STATUS_PROGRAM_CHANGE | MIDI_CHANNEL), (byte)((number - 1) & 0x7F), 0 };
+  MidiUSB.sendMIDI(event);
+  flushMIDI();
+
+}
+
+/// send a relative CC: signed steps, two's complement in 7 bits (Reaper's "Relative 2" mode)
+void MIDIOutput::relativeControl(int control, int steps) {
+
+  sendMIDIControlChange(control & 0x7F, steps & 0x7F);
+  flushMIDI();
+
+}
+
+/// Reaper has no MIDI-learnable target for an absolute tempo, so tap tempo is OSC only
+void MIDIOutput::setTempo(float bpm) {
+}
+
+/// hold the events that follow, up to endGroup(), and push them out together
+void MIDIOutput::beginGroup() {
+  MIDI_grouping = true;
+}
+
+void MIDIOutput::endGroup() {
+  MIDI_grouping = false;
+  flushMIDI();
+}
+
+/// stomps go out as they happen: there's no bridge to hold them for the beat
+void MIDIOutput::beginStomp() {
+}
+
+void MIDIOutput::endStomp() {
+}
+
+// Receive MIDI messages...
+
+/// act on one incoming control change (DAW feedback)
+void dispatchControlChange(byte control, byte value) {
+
+  // NRPN feedback arrives as a 4-CC sequence; we track it here and act when the data LSB completes it.
+  static byte nrpn_msb = 0;
+  static byte nrpn_lsb = 0;
+  static byte data_msb = 0;
+
+  if (control == CC_NRPN_MSB) {
+    nrpn_msb = value;
+  } else if (control == CC_NRPN_LSB) {
+    nrpn_lsb = value;
+  } else if (control == CC_DATA_ENTRY_MSB) {
+    data_msb = value;
+  } else if (control == CC_DATA_ENTRY_LSB) {
+    int value14 = (data_msb << 7) | value;
+    handleMIDI_FxParam(nrpn_msb, nrpn_lsb, value14 / 16383.0);
+  } else if (control == MIDI_CC_RECORD) {
+    handleMIDI_Record(value >= 64);
+  } else if ((control > MIDI_CC_FX_BYPASS_BASE) && (control <= MIDI_CC_FX_BYPASS_BASE + 9)) {
+    handleMIDI_FxBypass(control - MIDI_CC_FX_BYPASS_BASE, value >= 64);
+  }
+
+}
+
+/// receive and dispatch MIDI feedback
+void listenForMIDI() {
+
+  midiEventPacket_t event = MidiUSB.read();
+  while (event.header != 0) {
+
+    // only control changes on our channel are of interest
+    if ( (event.header == USB_MIDI_CIN_CONTROL_CHANGE) && (event.byte1 == (MIDI_STATUS_CONTROL_CHANGE | MIDI_CHANNEL)) ) {
+      last_OSC_receive_time = millis();
+      dispatchControlChange(event.byte2, event.byte3);
+    }
+
+    event = MidiUSB.read();
+  }
+
+}
+
+#endif
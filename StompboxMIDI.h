@@ -0,0 +1,57 @@
+#ifndef INCLUDED_StompboxMIDI_ALREADY
+
+#include "StompboxConfig.h"
+
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+
+// USB-MIDI support (the 32u4 enumerates as a class-compliant MIDI device alongside its USB serial port)
+#include <MIDIUSB.h>
+
+// I hate typing uint8_t
+typedef uint8_t byte;
+
+/*
+  MIDI mapping. In Reaper, MIDI-learn each target from the Stompbox MIDI input,
+  and enable MIDI feedback to the Stompbox MIDI output so the lamps can follow along:
+   - CC 20 on channel 1: record. Device sends 127 to toggle; Reaper feedback 127 = recording, 0 = not.
+   - CC 20 + n on channel 1: fx n bypass toggle (n = 1-9). Device sends 127 (learn the _S&M_FXBYPn action).
+   - CC 30 + n on channel 1: fx n "Bypass" parameter (learn it, with feedback). 127 = bypassed, 0 = active, both ways.
+   - NRPN (fx, param) on channel 1: fx n parameter m, 14-bit value. Parameter number MSB = fx, LSB = param.
+       Reaper's "14-bit NRPN" learn mode takes this directly and feeds it back the same way.
+   - Program change n - 1 on channel 1: recall scene n (learn the snapshot/preset action of your choice).
+   - relative knobs: CC per knob (see RELATIVE_KNOB_CONTROL), two's complement steps: 1 = +1, 127 = -1.
+       Learn the fx parameter with CC mode "Relative 2".
+*/
+const byte MIDI_CHANNEL = 0; // i.e. channel 1
+const byte MIDI_CC_RECORD = 20;
+const byte MIDI_CC_FX_BYPASS_TOGGLE_BASE = 20; // + fx index 1-9
+const byte MIDI_CC_FX_BYPASS_BASE = 30; // + fx index 1-9
+const byte MIDI_CC_TOGGLE = 127;
+
+void setupMIDI();
+void listenForMIDI();
+
+/// MIDI output backend for StompboxOutput (track is ignored: the mapping is for track 1 only)
+struct MIDIOutput {
+  static void recordToggle();
+  static void fxBypassToggle(int track, int fx);
+  static void setFxBypass(int track, int fx, bool bypassed);
+  static void setFxParam(int track, int fx, int param, float value);
+  static void scene(int number);
+  static void relativeControl(int control, int steps);
+  static void setTempo(float bpm);
+  static void beginGroup();
+  static void endGroup();
+  static void beginStomp();
+  static void endStomp();
+};
+
+// caller provides these
+void handleMIDI_Record(bool recording);
+void handleMIDI_FxBypass(int fx, bool bypassed);
+void handleMIDI_FxParam(int fx, int param, float value);
+
+#endif
+
+#define INCLUDED_StompboxMIDI_ALREADY
+#endif
@@ -0,0 +1,30 @@
+#include "StompboxMorph.h"
+
+/// a target's value at a pedal position: scene A at 0, scene B at 65535, in a straight line between
+uint16_t morphValue(const morph_target_s *target, uint16_t position) {
+
+  // (position to 15 bits, so span * position fits in 32)
+  int32_t span = (int32_t)target->scene_b - (int32_t)target->scene_a;
+  return target->scene_a + (span * (int32_t)(position >> 1)) / 32767;
+
+}
+
+/// is an update due for the pedal at this position? (it has moved since the last one, and that was long enough ago)
+// called every loop with the current position, so a move held back now goes out later: the latest position always gets there.
+bool takeMorphUpdate(morph_s *morph, uint16_t position) {
+
+  if (morph->sent && (position == morph->sent_position)) {
+    return false;
+  }
+
+  time_ms now = millis();
+  if (morph->sent && (now - morph->last_send_time < MORPH_SEND_INTERVAL)) {
+    return false;
+  }
+
+  morph->sent_position = position;
+  morph->sent = true;
+  morph->last_send_time = now;
+  return true;
+
+}
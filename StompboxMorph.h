@@ -0,0 +1,44 @@
+#ifndef INCLUDED_StompboxMorph_ALREADY
+
+#include <Arduino.h>
+#include "StompboxOSC.h"
+
+/*
+  Pedal morph: one pedal sweeps several fx parameters at once, each between its value in scene A (pedal heel down)
+  and scene B (toe down) -- e.g. clean rhythm to lead, drive, tone and level together.
+  Values are 16-bit fixed point (0-65535 for 0.0-1.0), as are pedal positions (see StompboxCurves.h),
+  so each update is a handful of integer multiplies.
+
+  Updates are coalesced and rate-capped: at most one every MORPH_SEND_INTERVAL, always for the pedal's latest
+  position (never a backlog of old ones), with every target in one bundle. A fast sweep sends fewer, bigger steps,
+  and the last step lands where the foot stopped.
+*/
+
+const int MAX_MORPH_TARGETS = 5;
+
+const time_ms MORPH_SEND_INTERVAL = 30;
+
+typedef struct morph_target_s {
+
+  int fx;
+  int fxparam;
+  uint16_t scene_a; // value at heel down
+  uint16_t scene_b; // value at toe down
+
+} morph_target_s;
+
+typedef struct morph_s {
+
+  int num_targets;
+  morph_target_s target[MAX_MORPH_TARGETS];
+  uint16_t sent_position;
+  bool sent; // anything sent yet?
+  time_ms last_send_time;
+
+} morph_s;
+
+uint16_t morphValue(const morph_target_s *target, uint16_t position);
+bool takeMorphUpdate(morph_s *morph, uint16_t position);
+
+#define INCLUDED_StompboxMorph_ALREADY
+#endif
@@ -1,9 +1,17 @@
 #include "StompboxOSC.h"
 #include "StompboxLEDs.h"
+#include "StompboxProfile.h"
+#include "StompboxEventLog.h"
+#include "StompboxResetRecord.h"
+#include "StompboxLatency.h"
+#include "StompboxDiagnostics.h"
+#include "StompboxLink.h"
 
 // OSC-over-USB support
 #include <SLIPEncodedSerial.h>
-#ifdef BOARD_HAS_USB_SERIAL
+#if STOMPBOX_SERIAL_UART
+SLIPEncodedSerial SLIPSerial(Serial1);
+#elif defined(BOARD_HAS_USB_SERIAL)
 SLIPEncodedUSBSerial SLIPSerial( thisBoardsSerialUSB );
 #else
 SLIPEncodedSerial SLIPSerial(Serial);
@@ -14,6 +22,20 @@ const time_ms MINIMUM_TIME_BETWEEN_OSC_SENDS = 10; // adjust to taste, but not l
 time_ms last_OSC_send_time;
 time_ms last_OSC_receive_time;
 
+bool OSC_timestamps = false;
+time_us last_OSC_packet_receive_us;
+
+bool OSC_quantise = false;
+bool OSC_stomp = false; // between beginStomp() and endStomp()
+bool OSC_bundling = false; // between beginOSCBundle() and endOSCBundle()
+byte OSC_bundle_count; // messages in the open bundle
+
+const uint32_t OSC_TIMETAG_STAMP = 0; // timetag seconds: plain device timestamp
+const uint32_t OSC_TIMETAG_QUANTISE = 1; // timetag seconds: device timestamp, and hold for the next boundary
+
+void handleOSC_Sync(OSCMessage &msg);
+void handleOSC_Quantise(OSCMessage &msg);
+
 /// open OSC-over-USB connection
 void setupOSC() {
  
@@ -33,11 +55,21 @@ void listenForOSC() {
   static OSCMessage *messageIN = new OSCMessage;
   static listening_status_e listeningFor = BUNDLE_OR_MESSAGE_START;
 
+  PROFILE_BEGIN(PROFILE_LISTEN_OSC);
+  enterResetPhase(PHASE_LISTEN_OSC);
+  noteResetInputBacklog(SLIPSerial.available());
+
   bool eot =  SLIPSerial.endofPacket();
   while (SLIPSerial.available() && !eot) {
 
     uint8_t data = SLIPSerial.read();
 
+    // (a framed packet's header and CRC are the link layer's: see StompboxLink.h)
+    if (!linkTakeByte(data, &data)) {
+      eot = SLIPSerial.endofPacket();
+      continue;
+    }
+
     // Reaper may send either OSC bundles or raw messages, unpredictably, so we must accept both equally
     // (surprisingly, the arduino OSC library does not handle this logic; it (unreasonably) expects you 
     // to know in advance which you'll be receiving. So we must do this peek-ahead here and track some state.)
@@ -49,10 +81,9 @@ void listenForOSC() {
         // "/"
         listeningFor = MESSAGE;
       } else {
-        char report[99];
-        sprintf(report, "expected # (35) or / (47), got %c (%d)", data, data);
-        sendOSCString("/foobar/error", "OSC got start of neither bundle nor message!");     
-        sendOSCString("/foobar/error", report);
+        // (counted, and reported later: never stop to send from in here)
+        diagnose(DIAG_OSC_BAD_START, data);
+        LOG_EVENT(EVENT_ERROR, EVENT_ERROR_OSC_START);
       }
     }
 
@@ -66,11 +97,35 @@ void listenForOSC() {
     eot =  SLIPSerial.endofPacket();
   }
 
-  if (eot) {
+  if (eot && !linkEndOfPacket()) {
+
+    // corrupt or cut short (counted by the link layer): whatever we've read of it goes
+    LOG_EVENT(EVENT_ERROR, EVENT_ERROR_LINK_CORRUPT);
+    bundleIN->empty();
+    messageIN->empty();
+    listeningFor = BUNDLE_OR_MESSAGE_START;
+
+  } else if (eot) {
+
+    // note arrival time as early as possible, for clock sync
+    last_OSC_packet_receive_us = micros();
+    // anything from the bridge (including its own sync and link messages, handled below) means it's there
+    if (listeningFor != BUNDLE_OR_MESSAGE_START) {
+      last_OSC_receive_time = millis();
+    }
+    LOG_EVENT(EVENT_RECEIVE, listeningFor == BUNDLE);
+    enterResetPhase(PHASE_DISPATCH);
+    if (listeningFor == MESSAGE) {
+      noteResetAddress(messageIN);
+    } else if ((listeningFor == BUNDLE) && (bundleIN->size() > 0)) {
+      noteResetAddress(bundleIN->getOSCMessage(0));
+    }
+
     if ( (listeningFor == BUNDLE) && bundleIN->hasError() ) {
       
-      // turn on a warning light for an OSC error
-      flashBuiltInLED();
+      // note the OSC error (this flashes the warning light, too)
+      LOG_EVENT(EVENT_ERROR, EVENT_ERROR_OSC_BUNDLE);
+      diagnose(DIAG_OSC_BAD_BUNDLE, bundleIN->getError());
       // setBuiltInLED(1); // @#@d
       // int err = bundleIN->getError();
       // char report[99];
@@ -122,7 +177,13 @@ void listenForOSC() {
       // sprintf(report, "got; (%d) '%s'", messageIN->incomingBufferSize, messageIN->incomingBuffer);
       //sendOSCString("/foobar/message", report);
 
-      dispatchMessage(messageIN);
+      // messages for the device itself, from the bridge, are handled here; everything else is the caller's business
+      if (!messageIN->dispatch("/stompbox/sync", handleOSC_Sync)
+          && !messageIN->dispatch("/stompbox/quantise", handleOSC_Quantise)
+          && !messageIN->dispatch("/stompbox/link", handleOSC_Link)
+          && !messageIN->dispatch("/stompbox/link/stats", handleOSC_LinkStats)) {
+        dispatchMessage(messageIN);
+      }
       messageIN->empty();
       listeningFor = BUNDLE_OR_MESSAGE_START;
       
@@ -131,20 +192,131 @@ void listenForOSC() {
   }
   // else wait for more...
 
+  PROFILE_END(PROFILE_LISTEN_OSC);
+
 }
 
 
+// Clock sync...
+
+/// handle a clock sync request from the bridge: /stompbox/sync t1 (bridge time)
+// We reply /stompbox/sync/reply t1 t2 t3 (t2: our receive time, t3: our send time), NTP style;
+// the bridge estimates clock offset and drift from these.
+void handleOSC_Sync(OSCMessage &msg) {
+
+  int32_t t1 = msg.getInt(0);
+  time_us t2 = last_OSC_packet_receive_us;
+
+  // from now on, stamp outgoing packets
+  OSC_timestamps = true;
+
+  OSCMessage reply("/stompbox/sync/reply");
+  reply.add(t1);
+  reply.add((int32_t)t2);
+  reply.add((int32_t)micros());
+  sendOSCReply(reply);
+
+}
+
+/// handle a quantise request from the bridge: /stompbox/quantise 1 (mark stomps for holding) or 0 (don't)
+void handleOSC_Quantise(OSCMessage &msg) {
+  OSC_quantise = (msg.getInt(0) != 0);
+}
+
 // Send OSC messages...
 
+/// write a big-endian 32-bit word to the SLIP stream
+void writeOSCInt32(uint32_t value) {
+
+  SLIPLink.write((uint8_t)(value >> 24));
+  SLIPLink.write((uint8_t)(value >> 16));
+  SLIPLink.write((uint8_t)(value >> 8));
+  SLIPLink.write((uint8_t)value);
+
+}
+
+/// write an OSC bundle header to the SLIP stream, with our clock (micros) as the timetag
+// Timetag seconds = 0 marks a device timestamp for the bridge, which rewrites it to "immediately" before passing it on;
+// seconds = 1 is the same, but asks the bridge to hold the contents for the next beat or bar (see OSC_quantise).
+// (we write the bundle by hand, rather than building an OSCBundle, to avoid another heap allocation per send)
+void writeOSCBundleHeader(uint32_t seconds, time_us stamp) {
+
+  SLIPLink.write((const uint8_t *)"#bundle", 8); // includes the terminating zero byte, as OSC requires
+  writeOSCInt32(seconds);
+  writeOSCInt32(stamp);
+
+}
+
+/// timetag seconds for the packet we're about to send (see writeOSCBundleHeader)
+uint32_t outgoingOSCTimetagSeconds() {
+  return (OSC_quantise && OSC_stomp) ? OSC_TIMETAG_QUANTISE : OSC_TIMETAG_STAMP;
+}
+
 /// send an OSC message over the serial port
 void sendOSCMessage(OSCMessage &msg) {
 
-  SLIPSerial.beginPacket();
-  msg.send(SLIPSerial); // send the bytes to the SLIP stream
-  SLIPSerial.endPacket(); // mark the end of the OSC Packet
+  uint8_t was_phase = enterResetPhase(PHASE_SEND);
+  noteResetFreeRam();
+
+  if (OSC_bundling) {
+    // one more element of the open bundle
+    writeOSCInt32(msg.bytes());
+    msg.send(SLIPLink);
+    msg.empty();
+    OSC_bundle_count++;
+    leaveResetPhase(was_phase);
+    return;
+  }
+
+  PROFILE_BEGIN(PROFILE_OSC_SEND);
+  linkBeginPacket();
+  if (OSC_timestamps) {
+    writeOSCBundleHeader(outgoingOSCTimetagSeconds(), micros());
+    writeOSCInt32(msg.bytes()); // bundle element size
+  }
+  msg.send(SLIPLink); // send the bytes to the SLIP stream
+  linkEndPacket(); // mark the end of the OSC Packet
+  latencyWire();
   msg.empty(); // free space occupied by message
+  PROFILE_END(PROFILE_OSC_SEND);
+  LOG_EVENT(EVENT_SEND, 1);
   last_OSC_send_time = millis();
   delay(MINIMUM_TIME_BETWEEN_OSC_SENDS); // throttle traffic to avoid crashing the connection. @#@t short blocking delay here is probably fine, but maybe not the best solution
+  leaveResetPhase(was_phase);
+}
+
+/// send a message for the bridge itself (a reply, report or diagnostic): sent as usual, but not counted as a send
+// by watchForDisconnection, which waits for an answer to each send. The bridge doesn't answer these.
+void sendOSCReply(OSCMessage &msg) {
+
+  time_ms was_send_time = last_OSC_send_time;
+  sendOSCMessage(msg);
+  last_OSC_send_time = was_send_time;
+
+}
+
+/// start a bundle: messages sent from now until endOSCBundle() go out in it, as one packet, with one pacing delay
+// (written straight to the SLIP stream as they come, so there's nothing to hold in memory)
+void beginOSCBundle() {
+
+  linkBeginPacket();
+  // stamped as usual once the bridge is syncing; otherwise a plain "immediately" bundle (timetag 0.1)
+  writeOSCBundleHeader(outgoingOSCTimetagSeconds(), OSC_timestamps ? micros() : 1);
+  OSC_bundling = true;
+  OSC_bundle_count = 0;
+
+}
+
+/// finish and send the bundle
+void endOSCBundle() {
+
+  OSC_bundling = false;
+  linkEndPacket();
+  latencyWire();
+  LOG_EVENT(EVENT_SEND, OSC_bundle_count);
+  last_OSC_send_time = millis();
+  delay(MINIMUM_TIME_BETWEEN_OSC_SENDS); // (see sendOSCMessage)
+
 }
 
 /// send an OSC message to a specified OSC address, containing a single specified float parameter value
@@ -189,4 +361,103 @@ void sendOSCTrigger(const char *address) {
   OSCMessage msg(address);
   sendOSCMessage(msg);
 
-}
\ No newline at end of file
+}
+
+// Semantic output, OSC flavor (see StompboxOutput.h)...
+
+/// ask the DAW to start or stop recording
+void OSCOutput::recordToggle() {
+  sendOSCTrigger("/record");
+}
+
+/// ask the DAW to enable or disable the specified fx plugin.
+void OSCOutput::fxBypassToggle(int track, int fx) {
+
+  // native Reaper OSC FX_BYPASS command doesn't work, or I'm not implementing it properly.
+  // (Reaper's OSC default config file is sparsely and tersely documented, with almost no discussion of how Reaper actually behaves over OSC.) 
+  // Luckily we have the S&M commands, and this sequence seems to work:
+
+  String addr = "/action/";
+  addr = addr + (40938 + track); // track 1: action 40939; track 2: action 40940, etc. No track 0.
+  sendOSCInt(addr.c_str(), 1);
+  
+  String msg = "_S&M_FXBYP";
+  msg = msg + fx; // fx = 3 and up only for our purposes
+  sendOSCString("/action/str", msg.c_str());
+  
+}
+
+/// ask the DAW to bypass or activate the specified fx plugin outright
+void OSCOutput::setFxBypass(int track, int fx, bool bypassed) {
+
+  // Reaper OSC pattern "b/track/@/fx/@/bypass" -- 1 means active, 0 means bypassed (as in the feedback we receive).
+  // @#@? see fxBypassToggle: this pattern has been unreliable here, so the stomp buttons stick with the S&M toggle.
+
+  String addr = "/track/";
+  addr = addr + track;
+  addr = addr + "/fx/";
+  addr = addr + fx;
+  addr = addr + "/bypass";
+  sendOSCInt(addr.c_str(), bypassed ? 0 : 1);
+
+}
+
+/// ask the DAW to set the specified fx plugin parameter to the specified (normalized float) value
+void OSCOutput::setFxParam(int track, int fx, int param, float value) {
+
+  // Reaper OSC pattern "n/track/@/fx/@/fxparam/@/value" -- n is for normalized (0.0-1.0)
+
+  String addr = "/track/";
+  addr = addr + track;
+  addr = addr + "/fx/";
+  addr = addr + fx;
+  addr = addr + "/fxparam/";
+  addr = addr + param;
+  addr = addr + "/value";
+  sendOSCFloat(addr.c_str(), value);
+
+}
+
+/// ask the DAW to recall a scene: we use SWS snapshots ("SWS: Recall snapshot n")
+void OSCOutput::scene(int number) {
+
+  String msg = "_SWSSNAPSHOT_GET";
+  msg = msg + number;
+  sendOSCString("/action/str", msg.c_str());
+
+}
+
+/// nudge a DAW control: trigger the specified action as a relative CC (Reaper pattern "f/action/@/cc/relative").
+// with DEVICE_ROTARY_CENTER 0, the argument is simply the signed number of steps.
+void OSCOutput::relativeControl(int action, int steps) {
+
+  String addr = "/action/";
+  addr = addr + action;
+  addr = addr + "/cc/relative";
+  sendOSCFloat(addr.c_str(), (float)steps);
+
+}
+
+/// ask the DAW to change the project tempo (Reaper pattern "f/tempo/raw": beats per minute)
+void OSCOutput::setTempo(float bpm) {
+  sendOSCFloat("/tempo/raw", bpm);
+}
+
+/// outputs up to endGroup() go out as one bundle
+void OSCOutput::beginGroup() {
+  beginOSCBundle();
+}
+
+void OSCOutput::endGroup() {
+  endOSCBundle();
+}
+
+/// what follows is a stomp: if the bridge is quantising, it will hold it for the next beat or bar
+// (all messages up to endStomp() are held and released together, in order)
+void OSCOutput::beginStomp() {
+  OSC_stomp = true;
+}
+
+void OSCOutput::endStomp() {
+  OSC_stomp = false;
+}
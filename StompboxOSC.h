@@ -1,5 +1,7 @@
 #ifndef INCLUDED_StompboxOSC_ALREADY
 
+#include "StompboxConfig.h"
+
 // OSC support
 #include <OSCBundle.h>
 // Note: OSC's clockless_trinket.h has a "#define DONE" that conflicts with other library code; I've renamed it to ASM_DONE
@@ -7,7 +9,9 @@
 
 // OSC-over-USB support
 #include <SLIPEncodedSerial.h>
-#ifdef BOARD_HAS_USB_SERIAL
+#if STOMPBOX_SERIAL_UART
+extern SLIPEncodedSerial SLIPSerial;
+#elif defined(BOARD_HAS_USB_SERIAL)
 extern SLIPEncodedUSBSerial SLIPSerial;
 #else
 extern SLIPEncodedSerial SLIPSerial;
@@ -15,6 +19,7 @@ extern SLIPEncodedSerial SLIPSerial;
 
 
 typedef unsigned long time_ms;
+typedef unsigned long time_us;
 
 typedef enum listening_status_e { BUNDLE_OR_MESSAGE_START, BUNDLE, MESSAGE } listening_status_e;
 
@@ -23,15 +28,43 @@ extern time_ms last_OSC_send_time;
 extern time_ms last_OSC_receive_time;
 extern const time_ms MINIMUM_TIME_BETWEEN_OSC_SENDS;
 
+// clock sync with the PC bridge. Once the bridge has asked for a sync, we stamp each outgoing packet with our send time
+// (micros(), carried in the timetag of a one-message bundle) so the bridge can measure the device->bridge leg per event.
+extern bool OSC_timestamps;
+extern time_us last_OSC_packet_receive_us;
+
+// beat quantisation, by the PC bridge. Once the bridge has asked for it, stomps are marked (in the same timetag)
+// for the bridge to hold until the next beat or bar boundary; everything else goes straight through.
+extern bool OSC_quantise;
+
 void setupOSC();
 void listenForOSC();
 
+void sendOSCMessage(OSCMessage &msg);
+void sendOSCReply(OSCMessage &msg);
+void beginOSCBundle();
+void endOSCBundle();
 void sendOSCFloat(const char *address, float value);
 void sendOSCInt(const char *address, int value);
 void sendOSCString(const char *address, const char *value);
 void sendOSCBool(const char *address, bool value);
 void sendOSCTrigger(const char *address);
 
+/// OSC output backend for StompboxOutput: Reaper's OSC control surface, via the PC bridge
+struct OSCOutput {
+  static void recordToggle();
+  static void fxBypassToggle(int track, int fx);
+  static void setFxBypass(int track, int fx, bool bypassed);
+  static void setFxParam(int track, int fx, int param, float value);
+  static void scene(int number);
+  static void relativeControl(int action, int steps);
+  static void setTempo(float bpm);
+  static void beginGroup();
+  static void endGroup();
+  static void beginStomp();
+  static void endStomp();
+};
+
 // caller provides these
 void dispatchBundleContents(OSCBundle *bundleIN);
 void dispatchMessage(OSCMessage *messageIN);
@@ -0,0 +1,103 @@
+#ifndef INCLUDED_StompboxOneEuro_ALREADY
+
+#include <Arduino.h>
+
+typedef unsigned long time_us;
+
+/*
+  One-Euro filter for the analog inputs (pedal, joystick): a low-pass whose cutoff rises with the signal's speed.
+  At rest the cutoff is low (MinCutoff), so ADC jitter is smoothed away; in a fast sweep it opens up
+  (by Beta per unit of speed), so the output keeps up with the foot instead of lagging behind it.
+  A fixed smoother has to pick one of those; a wah pedal wants both.
+
+  All fixed point, no floats: positions are 0-65535 (as in StompboxCurves.h), smoothing factors are Q15,
+  and the per-reading cost is three 32-bit divides. Readings needn't be evenly spaced: each one is weighed
+  by the time since the last (taken as 100 us to 20 ms, so a long stall doesn't throw the arithmetic).
+
+  Template parameters, in hundredths of a hertz:
+    MinCutoff:          the cutoff at rest. Lower is steadier, but slower to settle after a move.
+    Beta:               extra cutoff per full-range sweep per second (roughly). Higher follows fast moves more tightly.
+    DerivativeCutoff:   smoothing of the speed estimate itself. Too low, and a quick back-and-forth is over before the cutoff opens.
+  The cutoff tops out at 655 Hz, far beyond anything a foot does.
+*/
+
+template <uint16_t MinCutoff, uint16_t Beta, uint16_t DerivativeCutoff = 100>
+class OneEuro {
+
+  public:
+
+    /// the filtered position for a new reading (0-65535) taken at this time
+    uint16_t filter(uint16_t position, time_us now) {
+
+      if (!primed) {
+        // start where the input is, not at 0
+        value = position;
+        speed = 0;
+        last_time = now;
+        primed = true;
+        return position;
+      }
+
+      uint32_t dt = constrain(now - last_time, 100UL, 20000UL);
+      last_time = now;
+
+      // speed, in positions per 2^14 us (a full-range sweep in one second is about 1 << 10),
+      // smoothed, then held to +/- 2^15 (a sweep in about 30 ms: nothing a foot does is faster)
+      int32_t raw_speed = ((int32_t)position - value) * 16384 / (int32_t)dt;
+      raw_speed = constrain(raw_speed, -32767L, 32767L);
+      speed += smooth(raw_speed - speed, alpha(DerivativeCutoff, dt));
+
+      // cutoff opens with speed
+      uint32_t cutoff = MinCutoff + (((uint32_t)Beta * (uint32_t)abs(speed)) >> 10);
+      if (cutoff > 65535) {
+        cutoff = 65535;
+      }
+
+      value += smooth((int32_t)position - value, alpha(cutoff, dt));
+      return value;
+
+    }
+
+    /// forget the past: the next reading passes straight through
+    void reset() {
+      primed = false;
+    }
+
+  private:
+
+    int32_t value = 0;        // filtered position, 0-65535
+    int32_t speed = 0;        // filtered speed (see filter)
+    time_us last_time = 0;
+    bool primed = false;
+
+    /// the smoothing factor (Q15) for this cutoff (hundredths of a hertz) and interval (us): r / (1 + r), r = 2 pi fc dt
+    static uint16_t alpha(uint32_t cutoff, uint32_t dt) {
+
+      // 2 pi / (100 * 10^6) in Q15 is 1 / 485.7, near enough 1079 / 2^19 (cutoff * dt < 2^31 with dt capped, so no overflow)
+      uint32_t r = (((cutoff * dt) >> 9) * 1079) >> 10;
+      uint32_t one_minus = (1UL << 30) / (32768 + r);
+      return 32768 - one_minus;
+
+    }
+
+    /// a step of 'difference', scaled by alpha (Q15) and rounded. |difference| < 2^16, so the product fits
+    static int32_t smooth(int32_t difference, uint16_t alpha) {
+      return (difference * (int32_t)alpha + 16384) >> 15;
+    }
+
+};
+
+// the pedal inputs' smoothing (joystick axes and external pedal), shared with the host tests (Stompbox Host Tests/OneEuroTest.cpp):
+// 1 Hz at rest, opening up by about 20 Hz per full sweep per second. The speed estimate is smoothed at 10 Hz, not the usual 1:
+// any slower and it is still catching up when a quick rock of the pedal is over, so the output trails the foot more than
+// a plain EMA would. Raise the beta if sweeps feel sluggish; check with make one-euro-test.
+const uint16_t PEDAL_MIN_CUTOFF = 100;
+const uint16_t PEDAL_BETA = 2000;
+const uint16_t PEDAL_DERIVATIVE_CUTOFF = 1000;
+typedef OneEuro<PEDAL_MIN_CUTOFF, PEDAL_BETA, PEDAL_DERIVATIVE_CUTOFF> PedalFilter;
+
+// a smoothed pedal reading must move by more than this (ADC counts) to be sent: the filter has already taken out the jitter
+const int PEDAL_THRESHOLD = 4;
+
+#define INCLUDED_StompboxOneEuro_ALREADY
+#endif
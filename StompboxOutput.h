@@ -0,0 +1,106 @@
+#ifndef INCLUDED_StompboxOutput_ALREADY
+
+#include "StompboxConfig.h"
+#include "StompboxOSC.h"
+#include "StompboxMIDI.h"
+
+/*
+  Semantic output: what the control logic wants the DAW to do, independent of wire format.
+  Handlers call Output::recordToggle() etc.; the backend is picked at compile time (see StompboxConfig.h),
+  so every call is a plain static call into that backend -- no vtable, nothing to dispatch at runtime.
+  The forwarders here inline away (leaving the clamping), and the handler calls the backend's function directly;
+  the backends themselves are out of line, in their .cpp files, since each one builds and sends a packet.
+
+  A backend is a struct of static functions:
+    recordToggle()
+    fxBypassToggle(track, fx)
+    setFxBypass(track, fx, bypassed)
+    setFxParam(track, fx, param, value)   (value already clamped to 0.0-1.0)
+    scene(number)                         (1-based)
+    setTempo(bpm)
+    beginGroup(), endGroup()              (bracket outputs to go out as one update)
+    relativeControl(control, steps)       (steps already limited to +/-63)
+    beginStomp(), endStomp()              (bracket a stomp, which may be held for the beat; may do nothing)
+  OSCOutput is in StompboxOSC.h, MIDIOutput in StompboxMIDI.h.
+*/
+template <class Backend>
+class StompboxOutput {
+
+  public:
+
+    /// ask the DAW to start or stop recording
+    static inline void recordToggle() {
+      Backend::recordToggle();
+    }
+
+    /// ask the DAW to flip an fx between bypassed and active
+    // (a toggle, not a requested value: our current knowledge might be a guess,
+    // and this action itself will yield a reply with an accurate indication of the true new state)
+    static inline void fxBypassToggle(int track, int fx) {
+      Backend::fxBypassToggle(track, fx);
+    }
+
+    /// ask the DAW to bypass (or activate) an fx
+    static inline void setFxBypass(int track, int fx, bool bypassed) {
+      Backend::setFxBypass(track, fx, bypassed);
+    }
+
+    /// ask the DAW to set an fx parameter to a normalized (0.0-1.0) value
+    static inline void setFxParam(int track, int fx, int param, float value) {
+      if (value < 0.0) {
+        value = 0.0;
+      } else if (value > 1.0) {
+        value = 1.0;
+      }
+      Backend::setFxParam(track, fx, param, value);
+    }
+
+    /// nudge a DAW control by a number of steps, up or down, from wherever it really is.
+    // (what 'control' names is backend-specific: see the backends)
+    static inline void relativeControl(int control, int steps) {
+      if (steps < -63) {
+        steps = -63;
+      } else if (steps > 63) {
+        steps = 63;
+      }
+      Backend::relativeControl(control, steps);
+    }
+
+    /// ask the DAW to recall a whole stored scene (1-based)
+    static inline void scene(int number) {
+      Backend::scene(number);
+    }
+
+    /// ask the DAW to change the project tempo
+    static inline void setTempo(float bpm) {
+      Backend::setTempo(bpm);
+    }
+
+    /// what follows, up to endGroup(), goes to the DAW as one update (e.g. one OSC bundle), rather than one message at a time
+    static inline void beginGroup() {
+      Backend::beginGroup();
+    }
+
+    static inline void endGroup() {
+      Backend::endGroup();
+    }
+
+    /// what follows, up to endStomp(), is a stomp: the backend may hold it to land on the next beat or bar
+    static inline void beginStomp() {
+      Backend::beginStomp();
+    }
+
+    static inline void endStomp() {
+      Backend::endStomp();
+    }
+
+};
+
+#if STOMPBOX_TRANSPORT == STOMPBOX_TRANSPORT_MIDI
+typedef StompboxOutput<MIDIOutput> Output;
+#else
+typedef StompboxOutput<OSCOutput> Output;
+#endif
+
+#define INCLUDED_StompboxOutput_ALREADY
+#endif
@@ -0,0 +1,39 @@
+#ifndef INCLUDED_StompboxProfile_ALREADY
+
+#include "StompboxConfig.h"
+#include <Arduino.h>
+
+/*
+  Cycle-count profiling, in the simulator (see Stompbox Simulator/).
+  With STOMPBOX_PROFILE set, each profiled section writes its slot number to a spare I/O register as it starts (GPIOR1)
+  and as it ends (GPIOR2): one OUT instruction each, no timer, no interrupt, nothing kept on the device. The simulator
+  watches those registers and stamps every write with its cycle count, so the counts it reports are exact, and the same
+  from one run of the same image and stimulus to the next.
+  With STOMPBOX_PROFILE off (the default), the PROFILE_ macros compile to nothing.
+*/
+
+// what we measure (the simulator has the same list, for its report)
+typedef enum profile_slot_e {
+  PROFILE_LOOP,             // one whole pass of loop()
+  PROFILE_SCAN_CONTROLS,    // scanControls(), including any sends it triggers
+  PROFILE_LISTEN_OSC,       // listenForOSC(), including dispatch
+  PROFILE_OSC_SEND,         // writing one OSC packet to the SLIP stream (not counting the pacing delay)
+  PROFILE_LED_SHOW,         // one FastLED.show() -- interrupts are off for most of it
+  PROFILE_ROTARY_ISR,       // one rotary encoder interrupt
+  NUM_PROFILE_SLOTS
+} profile_slot_e;
+
+#if STOMPBOX_PROFILE
+
+#define PROFILE_BEGIN(slot) (GPIOR1 = (slot))
+#define PROFILE_END(slot) (GPIOR2 = (slot))
+
+#else
+
+#define PROFILE_BEGIN(slot)
+#define PROFILE_END(slot)
+
+#endif
+
+#define INCLUDED_StompboxProfile_ALREADY
+#endif
@@ -0,0 +1,99 @@
+#include "StompboxResetRecord.h"
+#include "StompboxOSC.h"
+
+const uint16_t RESET_RECORD_MAGIC = 0x5B0C;
+
+// the live record, and (copied out at boot) the one the last run left
+reset_record_s reset_record __attribute__((section(".noinit")));
+reset_record_s last_reset_record;
+bool last_reset_warm;
+
+// MCUSR as we found it, caught before the C runtime starts (see captureResetFlags)
+uint8_t reset_flags __attribute__((section(".noinit")));
+
+/// catch the reset flags and clear them for next time, before main() (and before anything else touches them)
+void captureResetFlags() __attribute__((naked, used, section(".init3")));
+void captureResetFlags() {
+  reset_flags = MCUSR;
+  MCUSR = 0;
+}
+
+// the heap's top (avr-libc)
+extern char __heap_start;
+extern char *__brkval;
+
+/// bytes free between the heap and the stack, right here
+uint16_t freeRam() {
+
+  char top;
+  return &top - (__brkval ? __brkval : &__heap_start);
+
+}
+
+/// keep what the last run left, and start a fresh record for this one
+void setupResetRecord() {
+
+  last_reset_warm = (reset_record.magic == RESET_RECORD_MAGIC);
+  last_reset_record = reset_record;
+
+  memset(&reset_record, 0, sizeof(reset_record));
+  reset_record.magic = RESET_RECORD_MAGIC;
+  reset_record.phase = PHASE_SETUP;
+  reset_record.min_free_ram = freeRam();
+
+}
+
+/// once per pass of loop()
+// (free RAM is sampled here and in sends, where the stack runs deepest and the OSC library allocates)
+void noteResetLoop() {
+
+  reset_record.loops++;
+  reset_record.uptime = millis();
+  noteResetFreeRam();
+
+}
+
+void noteResetFreeRam() {
+
+  uint16_t free_ram = freeRam();
+  if (free_ram < reset_record.min_free_ram) {
+    reset_record.min_free_ram = free_ram;
+  }
+
+}
+
+void noteResetInputBacklog(int available) {
+
+  if (available > reset_record.input_backlog) {
+    reset_record.input_backlog = (available > 255) ? 255 : available;
+  }
+
+}
+
+/// note the address of a message we're about to dispatch (only its start: enough to tell them apart)
+void noteResetAddress(OSCMessage *msg) {
+
+  msg->getAddress(reset_record.last_address, 0, RESET_ADDRESS_SIZE - 1);
+  reset_record.last_address[RESET_ADDRESS_SIZE - 1] = 0;
+
+}
+
+/// tell the bridge how the last run ended: /stompbox/reset ,iiiiiiis
+//  <MCUSR at this boot> <warm: did the record survive?> <then, from the last run:> <phase> <lowest free RAM> <most input backlog>
+//  <loops> <uptime ms> <last address>
+// (the last run's values are meaningless after a power-up, when warm is 0)
+void reportResetRecord() {
+
+  OSCMessage msg("/stompbox/reset");
+  msg.add((int32_t)reset_flags);
+  msg.add((int32_t)last_reset_warm);
+  msg.add((int32_t)last_reset_record.phase);
+  msg.add((int32_t)last_reset_record.min_free_ram);
+  msg.add((int32_t)last_reset_record.input_backlog);
+  msg.add((int32_t)last_reset_record.loops);
+  msg.add((int32_t)last_reset_record.uptime);
+  last_reset_record.last_address[RESET_ADDRESS_SIZE - 1] = 0; // (a warm record should be terminated, but make sure)
+  msg.add(last_reset_warm ? last_reset_record.last_address : "");
+  sendOSCReply(msg);
+
+}
@@ -0,0 +1,65 @@
+#ifndef INCLUDED_StompboxResetRecord_ALREADY
+
+#include <Arduino.h>
+#include <OSCMessage.h>
+
+/*
+  What we were doing when the last reset came: a small record in RAM that the C runtime doesn't clear at boot (.noinit),
+  kept up to date as we run (a few byte stores per loop phase), and reported to the bridge once it's connected.
+  A heap exhaustion or a hang then shows up as more than a startup light show: the phase we were in, how low free RAM had got,
+  how far behind the serial input was, and the start of the last OSC address we dispatched.
+
+  A record that survived (its magic number intact) means a warm reset: the RAM kept power. Otherwise it was a power-up.
+  The reset flags (MCUSR) are caught before anything else runs, but the Caterina bootloader clears them before we start,
+  so on a stock ItsyBitsy they usually read 0; telling warm from cold is the part to rely on.
+*/
+
+// where in the loop we are (the bridge has the same list)
+typedef enum loop_phase_e {
+  PHASE_SETUP,
+  PHASE_SCAN_CONTROLS,
+  PHASE_LISTEN_OSC,
+  PHASE_DISPATCH,           // handling a received packet
+  PHASE_LISTEN_MIDI,
+  PHASE_SEND,               // writing a packet to the host (inside any of the others)
+  PHASE_LED_SHOW,           // FastLED.show() (inside any of the others)
+  PHASE_HIBERNATING,
+  NUM_LOOP_PHASES
+} loop_phase_e;
+
+const int RESET_ADDRESS_SIZE = 12; // (including the terminator)
+
+typedef struct reset_record_s {
+
+  uint16_t magic;               // RESET_RECORD_MAGIC once set up: if it's there at boot, the record survived
+  uint8_t phase;                // loop_phase_e last entered
+  uint8_t input_backlog;        // most serial bytes seen waiting at once (to 255)
+  uint16_t min_free_ram;        // lowest free RAM (between heap and stack) seen
+  uint32_t loops;               // passes of loop() since boot
+  uint32_t uptime;              // millis() at the last pass
+  char last_address[RESET_ADDRESS_SIZE]; // start of the last OSC address dispatched
+
+} reset_record_s;
+
+extern reset_record_s reset_record;
+
+void setupResetRecord();
+void noteResetLoop();
+void noteResetFreeRam();
+void noteResetInputBacklog(int available);
+void noteResetAddress(OSCMessage *msg);
+void reportResetRecord();
+
+/// enter a phase; returns the one we were in, for leaveResetPhase (phases inside phases: sends and LED shows)
+inline uint8_t enterResetPhase(loop_phase_e phase) {
+  uint8_t was = reset_record.phase;
+  reset_record.phase = phase;
+  return was;
+}
+
+inline void leaveResetPhase(uint8_t was) {
+  reset_record.phase = was;
+}
+
+#define INCLUDED_StompboxResetRecord_ALREADY
+#endif
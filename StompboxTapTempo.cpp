@@ -0,0 +1,159 @@
+#include "StompboxTapTempo.h"
+
+// Tap capture...
+
+// a press counts only if the pin had been quiet this long before it (so neither press nor release bounces count)
+const time_us TAP_DEBOUNCE_US = 20000;
+
+// per port B bit: time of the latest press, and of the latest edge of either kind
+volatile time_us tap_edge_us[8];
+volatile time_us tap_change_us[8];
+// port B bits with a press the loop hasn't taken yet
+volatile byte tap_edge_pending = 0;
+byte tap_previous_pins = 0xFF;
+
+ISR(PCINT0_vect) {
+
+  time_us now = micros();
+  byte pins = PINB;
+  byte changed = (pins ^ tap_previous_pins) & PCMSK0;
+  tap_previous_pins = pins;
+
+  for (byte bit = 0; bit < 8; bit++) {
+    byte mask = _BV(bit);
+    if (changed & mask) {
+      // buttons make to ground: high to low is a press
+      if (!(pins & mask) && (now - tap_change_us[bit] >= TAP_DEBOUNCE_US)) {
+        tap_edge_us[bit] = now;
+        tap_edge_pending |= mask;
+      }
+      tap_change_us[bit] = now;
+    }
+  }
+
+}
+
+/// timestamp presses on whichever of these pins have pin change interrupts (port B only, on the 32u4)
+void setupTapCapture(const byte pins[], int count) {
+
+  byte oldSREG = SREG;
+  noInterrupts();
+
+  for (int ii = 0; ii < count; ii++) {
+    if (digitalPinToPCICR(pins[ii])) {
+      PCMSK0 |= _BV(digitalPinToPCMSKbit(pins[ii]));
+    }
+  }
+  tap_previous_pins = PINB;
+  PCIFR = _BV(PCIF0);
+  PCICR |= _BV(PCIE0);
+
+  SREG = oldSREG;
+
+}
+
+/// take the interrupt-captured time of this pin's latest press, if there's one we haven't taken (and the pin has capture)
+bool takeTapEdge(byte pin, time_us *when) {
+
+  if (!digitalPinToPCICR(pin)) {
+    return false;
+  }
+  byte mask = _BV(digitalPinToPCMSKbit(pin));
+  bool pending = false;
+
+  byte oldSREG = SREG;
+  noInterrupts();
+  if (tap_edge_pending & mask) {
+    *when = tap_edge_us[digitalPinToPCMSKbit(pin)];
+    tap_edge_pending &= ~mask;
+    pending = true;
+  }
+  SREG = oldSREG;
+
+  return pending;
+}
+
+// Tempo estimate...
+
+const int TAP_HISTORY = 8; // taps kept for the fit
+const int TAP_MINIMUM_TAPS = 4; // taps needed (on the beat) before we estimate at all
+const float TAP_TOLERANCE = 0.2; // how far off a beat (as a fraction of the median interval) a tap may be and still count
+const float TAP_STABILITY = 0.01; // how closely (as a fraction) consecutive estimates must agree to offer a tempo
+
+time_us tap_times[TAP_HISTORY];
+int tap_count = 0;
+float tap_previous_bpm = 0.0;
+
+/// one more tap: returns the tempo in bpm once it's stable, otherwise 0
+float tapTempo(time_us when) {
+
+  if (tap_count > 0) {
+    time_us interval = when - tap_times[tap_count - 1];
+    if (interval < TAP_MINIMUM_INTERVAL_US) {
+      return 0.0;
+    }
+    if (interval > TAP_TIMEOUT_US) {
+      // a new tempo
+      tap_count = 0;
+      tap_previous_bpm = 0.0;
+    }
+  }
+
+  if (tap_count == TAP_HISTORY) {
+    for (int ii = 1; ii < TAP_HISTORY; ii++) {
+      tap_times[ii - 1] = tap_times[ii];
+    }
+    tap_count--;
+  }
+  tap_times[tap_count++] = when;
+
+  if (tap_count < TAP_MINIMUM_TAPS) {
+    return 0.0;
+  }
+
+  // median interval (insertion sort: there are only a few)
+  float intervals[TAP_HISTORY - 1];
+  int num_intervals = tap_count - 1;
+  for (int ii = 0; ii < num_intervals; ii++) {
+    float interval = tap_times[ii + 1] - tap_times[ii];
+    int jj = ii;
+    while ((jj > 0) && (intervals[jj - 1] > interval)) {
+      intervals[jj] = intervals[jj - 1];
+      jj--;
+    }
+    intervals[jj] = interval;
+  }
+  float median = intervals[num_intervals / 2];
+
+  // least-squares fit of tap time against beat number, counting back from the latest tap.
+  // (times relative to the latest tap stay small enough for float to hold to the microsecond)
+  float sum_n = 0.0, sum_t = 0.0, sum_nn = 0.0, sum_nt = 0.0;
+  int used = 0;
+  for (int ii = 0; ii < tap_count; ii++) {
+    float t = -(float)(when - tap_times[ii]);
+    float beats = t / median;
+    float n = round(beats);
+    if (fabs(beats - n) > TAP_TOLERANCE) {
+      continue; // not on a beat
+    }
+    sum_n += n;
+    sum_t += t;
+    sum_nn += n * n;
+    sum_nt += n * t;
+    used++;
+  }
+  if (used < TAP_MINIMUM_TAPS) {
+    return 0.0;
+  }
+  float denominator = used * sum_nn - sum_n * sum_n;
+  if (denominator <= 0.0) {
+    return 0.0;
+  }
+  float period = (used * sum_nt - sum_n * sum_t) / denominator;
+  float bpm = 60.0e6 / period;
+
+  bool stable = (tap_previous_bpm > 0.0) && (fabs(bpm - tap_previous_bpm) < bpm * TAP_STABILITY);
+  tap_previous_bpm = bpm;
+  return stable ? bpm : 0.0;
+
+}
@@ -0,0 +1,29 @@
+#ifndef INCLUDED_StompboxTapTempo_ALREADY
+
+#include <Arduino.h>
+#include "StompboxOSC.h"
+
+/*
+  Tap tempo.
+  Taps are timestamped from pin change interrupts, so the tempo doesn't depend on how long the loop was busy
+  (sending OSC, lighting LEDs...) when the foot came down. Only port B pins have pin change interrupts on the 32u4:
+  of our buttons that's 1, 5, knob select 1 and joystick select (pins 10, 9, 8, 15). Taps on other buttons are
+  timestamped by the loop, as it notices them: still usable, just less steady.
+
+  The estimate is a least-squares fit of tap time against beat number, over the last few taps.
+  Beat numbers come from the median interval, so a missed tap (a double-length gap) still counts,
+  and taps that don't fall near any beat (stumbles, bounces) are left out of the fit.
+  We only offer a tempo once two estimates in a row agree.
+*/
+
+// taps further apart than this start a new tempo (30 bpm)
+const time_us TAP_TIMEOUT_US = 2000000;
+// taps closer together than this are bounces or stumbles, not beats (300 bpm)
+const time_us TAP_MINIMUM_INTERVAL_US = 200000;
+
+void setupTapCapture(const byte pins[], int count);
+bool takeTapEdge(byte pin, time_us *when);
+float tapTempo(time_us when);
+
+#define INCLUDED_StompboxTapTempo_ALREADY
+#endif